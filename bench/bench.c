@@ -0,0 +1,614 @@
+/* bench -- compare the startup cost of the EWE Coreutils against GNU's
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* gcc -O2 bench/bench.c -o bench/bench */
+
+/* Every tool is run RUNS times with posix_spawn, from just before the spawn
+   to wait4 returning is its latency. One more run under ptrace counts its
+   system calls (the execve itself excluded), ru_maxrss of the runs gives the
+   peak RSS. The GNU equivalent of every tool is measured the same way, and
+   the lot is written out as JSON, so two releases can be diffed:
+
+     bench -n 2000 -o before.json
+     bench -n 2000 --ewe-dir src/tiny -o after.json true false */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/ptrace.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+
+#define PROGRAM_NAME "bench"
+#define AUTHOR "netheround"
+
+#define DEFAULT_RUNS 1000
+#define DEFAULT_WARMUP 50
+#define DEFAULT_EWE_DIR "bin/linux"
+
+/* syscall numbers counted one by one, larger ones only in the total */
+#define MAX_SYSCALL_NR 512
+
+/* replaced by the scratch directory in the arguments of a case */
+#define DIR_TOKEN "@DIR@"
+
+extern char **environ;
+
+/* a tool, the arguments it runs with, and what undoes its work between runs */
+struct bench_case
+{
+    const char *name;
+    const char *gnu_name;
+    const char *args[4];
+
+    /* directories removed (in order) after every run, relative to @DIR@ */
+    const char *cleanup[4];
+};
+
+static const struct bench_case cases[] = {
+    {"md", "mkdir", {"-p", DIR_TOKEN "/a/b/c"}, {"a/b/c", "a/b", "a"}},
+    {"mkdir", "mkdir", {DIR_TOKEN "/d"}, {"d"}},
+    {"cwd", "pwd", {0}, {0}},
+    {"tt", "tty", {"-s"}, {0}},
+    {"true", "true", {0}, {0}},
+    {"false", "false", {0}, {0}},
+    {"delay", "sleep", {"0"}, {0}},
+
+    // terminating...
+    {NULL, NULL, {0}, {0}}
+};
+
+struct bench_result
+{
+    /* why the tool wasn't measured, NULL if it was */
+    const char *skipped;
+    char path[PATH_MAX];
+    int exit_status;
+
+    /* microseconds, sorted */
+    double *latency;
+    size_t runs;
+
+    long max_rss_kb;
+    long syscalls;
+    long by_nr[MAX_SYSCALL_NR];
+};
+
+/* options */
+
+enum
+{
+    EWE_DIR_OPTION = CHAR_MAX + 1,
+    NO_GNU_OPTION,
+    HELP_OPTION,
+    VERSION_OPTION
+};
+
+static struct option const long_options[] = {
+    {"runs", required_argument, 0, 'n'},
+    {"warmup", required_argument, 0, 'w'},
+    {"output", required_argument, 0, 'o'},
+    {"ewe-dir", required_argument, 0, EWE_DIR_OPTION},
+    {"no-gnu", no_argument, 0, NO_GNU_OPTION},
+    {"help", no_argument, 0, HELP_OPTION},
+    {"version", no_argument, 0, VERSION_OPTION},
+
+    // terminating...
+    {0, 0, 0, 0}
+};
+
+// ...
+
+void
+usage (int status)
+{
+    if (status != EXIT_SUCCESS) {
+        printf("Try '%s --help' for more information.\n", PROGRAM_NAME);
+        exit(status);
+    }
+
+    printf("Usage: %s [OPTION]... [TOOL]...\n"
+    "Measure the latency, system calls and peak RSS of the TOOL(s), all of them\n"
+    "by default, and of their GNU equivalents; write the results as JSON.\n\n", PROGRAM_NAME);
+
+    puts("Options:\n"
+    "  -n, --runs=N\t\ttimed runs of every tool (default 1000)\n"
+    "  -w, --warmup=N\truns before timing (default 50)\n"
+    "  -o, --output=FILE\twrite the JSON to FILE instead of standard output\n"
+    "      --ewe-dir=DIR\twhere the EWE tools are (default bin/linux)\n"
+    "      --no-gnu\t\tdon't measure the GNU tools\n"
+    "      --help\t\tdisplay this help and exit\n"
+    "      --version\t\toutput version information and exit\n");
+
+    printf("Tools:\n ");
+    for (const struct bench_case *c = cases; c->name != NULL; c++)
+        printf(" %s (%s)", c->name, c->gnu_name);
+    printf("\n");
+    exit(status);
+}
+
+void
+version_info()
+{
+    printf("%s (EWE Coreutils) 0.0.1\n"
+    "Copyright (C) 2024\n"
+    "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
+    "This is free software: you are free to change and redistribute it.\n"
+    "\nWritten by %s\n", PROGRAM_NAME, AUTHOR);
+    exit(EXIT_SUCCESS);
+}
+
+static double
+elapsed_us (const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e6
+        + (double)(end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+static int
+cmp_double (const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* nearest-rank percentile of the sorted V */
+static double
+percentile (const double *v, size_t n, double p)
+{
+    size_t rank = (size_t)(p / 100.0 * (double)n + 0.999999);
+    if (rank < 1)
+        rank = 1;
+    if (rank > n)
+        rank = n;
+    return v[rank - 1];
+}
+
+/* looks NAME up in $PATH, like execvp would. */
+static bool
+find_in_path (const char *name, char *path)
+{
+    const char *dirs = getenv("PATH");
+    if (dirs == NULL)
+        dirs = "/usr/bin:/bin";
+
+    while (*dirs != '\0') {
+        size_t len = strcspn(dirs, ":");
+        snprintf(path, PATH_MAX, "%.*s/%s", (int)len, len ? dirs : ".", name);
+        if (access(path, X_OK) == 0)
+            return true;
+        dirs += len + (dirs[len] == ':');
+    }
+    return false;
+}
+
+/* why PATH can't be run, NULL if it can. */
+static const char *
+tool_skipped (const char *path)
+{
+    if (access(path, X_OK) == 0)
+        return NULL;
+    return errno == ENOENT ? "not found" : "not executable";
+}
+
+/* ARGV for a run of C as PATH, @DIR@ replaced by DIR. */
+static char **
+build_argv (const struct bench_case *c, const char *path, const char *dir)
+{
+    static char args[4][PATH_MAX];
+    static char *argv[6];
+    size_t n = 0;
+
+    argv[n++] = (char *)path;
+    for (size_t i = 0; i < 4 && c->args[i] != NULL; i++) {
+        const char *arg = c->args[i];
+        if (strncmp(arg, DIR_TOKEN, strlen(DIR_TOKEN)) == 0)
+            snprintf(args[i], PATH_MAX, "%s%s", dir, arg + strlen(DIR_TOKEN));
+        else
+            snprintf(args[i], PATH_MAX, "%s", arg);
+        argv[n++] = args[i];
+    }
+    argv[n] = NULL;
+    return argv;
+}
+
+static void
+cleanup (const struct bench_case *c, const char *dir)
+{
+    char path[PATH_MAX];
+    for (size_t i = 0; i < 4 && c->cleanup[i] != NULL; i++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, c->cleanup[i]);
+        rmdir(path);
+    }
+}
+
+/* one timed run, stdio on /dev/null. Returns the wait status, -1 if the spawn failed. */
+static int
+run_once (char **argv, double *latency, long *max_rss_kb)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    struct timespec start, end;
+    struct rusage ru;
+    pid_t pid;
+    int status = -1;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (posix_spawn(&pid, argv[0], &actions, NULL, argv, environ) == 0
+        && wait4(pid, &status, 0, &ru) == pid) {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        *latency = elapsed_us(&start, &end);
+        if (ru.ru_maxrss > *max_rss_kb)
+            *max_rss_kb = ru.ru_maxrss;
+    }
+
+    posix_spawn_file_actions_destroy(&actions);
+    return status;
+}
+
+/* runs ARGV once under ptrace, counting the system calls it enters. */
+static bool
+count_syscalls (char **argv, struct bench_result *r)
+{
+    pid_t pid = fork();
+    if (pid == -1)
+        return false;
+
+    if (pid == 0) {
+        int fd = open("/dev/null", O_RDWR);
+        dup2(fd, STDIN_FILENO);
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+
+    int status;
+    /* the SIGTRAP of the execve */
+    if (waitpid(pid, &status, 0) != pid || !WIFSTOPPED(status)) {
+        return false;
+    }
+    ptrace(PTRACE_SETOPTIONS, pid, NULL, PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL);
+
+    bool ok = true;
+    bool in_syscall = false;
+    int sig = 0;
+    while (true) {
+        if (ptrace(PTRACE_SYSCALL, pid, NULL, (void *)(long)sig) == -1) {
+            ok = false;
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            break;
+        }
+        if (waitpid(pid, &status, 0) != pid || WIFEXITED(status) || WIFSIGNALED(status))
+            break;
+
+        sig = 0;
+        if (WSTOPSIG(status) != (SIGTRAP | 0x80)) {
+            /* a real signal, delivered on the next resume */
+            sig = WSTOPSIG(status);
+            continue;
+        }
+
+        /* exit_group never gets its exit stop, so entries are counted */
+        in_syscall = !in_syscall;
+        if (!in_syscall)
+            continue;
+
+        r->syscalls++;
+#ifdef PTRACE_GET_SYSCALL_INFO
+        struct __ptrace_syscall_info info;
+        if (ptrace(PTRACE_GET_SYSCALL_INFO, pid, (void *)sizeof(info), &info) > 0
+            && info.op == PTRACE_SYSCALL_INFO_ENTRY && info.entry.nr < MAX_SYSCALL_NR)
+            r->by_nr[info.entry.nr]++;
+#endif
+    }
+    return ok;
+}
+
+static void
+bench_tool (const struct bench_case *c, struct bench_result *r, const char *dir,
+    size_t runs, size_t warmup)
+{
+    char **argv = build_argv(c, r->path, dir);
+    double ignored;
+    long ignored_rss = 0;
+
+    for (size_t i = 0; i < warmup; i++) {
+        run_once(argv, &ignored, &ignored_rss);
+        cleanup(c, dir);
+    }
+
+    r->latency = (double *)calloc(runs, sizeof(double));
+    if (r->latency == NULL) {
+        fprintf(stderr, "%s: memory exhausted\n", PROGRAM_NAME);
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < runs; i++) {
+        int status = run_once(argv, &r->latency[r->runs], &r->max_rss_kb);
+        cleanup(c, dir);
+        if (status == -1)
+            continue;
+        r->exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        r->runs++;
+    }
+    qsort(r->latency, r->runs, sizeof(double), cmp_double);
+
+    if (!count_syscalls(argv, r))
+        r->syscalls = -1;
+    cleanup(c, dir);
+}
+
+static void
+json_string (FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s != '\0'; s++) {
+        unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\')
+            fprintf(out, "\\%c", ch);
+        else if (ch < 0x20)
+            fprintf(out, "\\u%04x", ch);
+        else
+            fputc(ch, out);
+    }
+    fputc('"', out);
+}
+
+static void
+json_result (FILE *out, const struct bench_result *r)
+{
+    fprintf(out, "{\"path\": ");
+    json_string(out, r->path);
+
+    if (r->skipped != NULL) {
+        fprintf(out, ", \"skipped\": ");
+        json_string(out, r->skipped);
+        fprintf(out, "}");
+        return;
+    }
+
+    double sum = 0;
+    for (size_t i = 0; i < r->runs; i++)
+        sum += r->latency[i];
+
+    fprintf(out, ", \"runs\": %zu, \"exit_status\": %d", r->runs, r->exit_status);
+    if (r->runs > 0) {
+        fprintf(out, ",\n        \"latency_us\": {\"min\": %.1f, \"p50\": %.1f, \"p90\": %.1f, "
+            "\"p99\": %.1f, \"max\": %.1f, \"mean\": %.1f}",
+            r->latency[0], percentile(r->latency, r->runs, 50),
+            percentile(r->latency, r->runs, 90), percentile(r->latency, r->runs, 99),
+            r->latency[r->runs - 1], sum / (double)r->runs);
+    }
+    fprintf(out, ",\n        \"max_rss_kb\": %ld, \"syscalls\": %ld", r->max_rss_kb, r->syscalls);
+
+    fprintf(out, ", \"syscalls_by_nr\": {");
+    bool first = true;
+    for (size_t nr = 0; nr < MAX_SYSCALL_NR; nr++) {
+        if (r->by_nr[nr] == 0)
+            continue;
+        fprintf(out, "%s\"%zu\": %ld", first ? "" : ", ", nr, r->by_nr[nr]);
+        first = false;
+    }
+    fprintf(out, "}}");
+}
+
+static void
+report_result (const char *name, const struct bench_result *r)
+{
+    if (r->skipped != NULL) {
+        fprintf(stderr, "  %-8s %-28s %s\n", name, r->path, r->skipped);
+        return;
+    }
+    if (r->runs == 0) {
+        fprintf(stderr, "  %-8s %-28s failed to run\n", name, r->path);
+        return;
+    }
+    fprintf(stderr, "  %-8s %-28s p50 %8.1fus  p99 %8.1fus  %4ld syscalls  %6ld KB\n",
+        name, r->path, percentile(r->latency, r->runs, 50),
+        percentile(r->latency, r->runs, 99), r->syscalls, r->max_rss_kb);
+}
+
+static bool
+is_selected (const char *name, int argc, char **argv)
+{
+    if (optind >= argc)
+        return true;
+    for (int i = optind; i < argc; i++)
+        if (strcmp(argv[i], name) == 0)
+            return true;
+    return false;
+}
+
+static size_t
+parse_count (const char *arg)
+{
+    char *end;
+    errno = 0;
+    long n = strtol(arg, &end, 10);
+    if (end == arg || *end != '\0' || errno == ERANGE || n < 0) {
+        printf("%s: invalid number '%s'\n", PROGRAM_NAME, arg);
+        usage(EXIT_FAILURE);
+    }
+    return (size_t)n;
+}
+
+int
+main (int argc, char **argv)
+{
+    size_t runs = DEFAULT_RUNS;
+    size_t warmup = DEFAULT_WARMUP;
+    const char *output = NULL;
+    const char *ewe_dir = DEFAULT_EWE_DIR;
+    bool with_gnu = true;
+
+    int c;
+    while ((c = getopt_long(argc, argv, "n:w:o:", long_options, NULL)) != -1) {
+        switch (c)
+        {
+            case 'n':
+                runs = parse_count(optarg);
+                break;
+
+            case 'w':
+                warmup = parse_count(optarg);
+                break;
+
+            case 'o':
+                output = optarg;
+                break;
+
+            case EWE_DIR_OPTION:
+                ewe_dir = optarg;
+                break;
+
+            case NO_GNU_OPTION:
+                with_gnu = false;
+                break;
+
+            case HELP_OPTION:
+                usage(EXIT_SUCCESS);
+                break;
+
+            case VERSION_OPTION:
+                version_info();
+                break;
+
+            default:
+                usage(EXIT_FAILURE);
+        }
+    }
+
+    if (runs == 0) {
+        printf("%s: at least one run is needed\n", PROGRAM_NAME);
+        usage(EXIT_FAILURE);
+    }
+
+    for (int i = optind; i < argc; i++) {
+        const struct bench_case *bc = cases;
+        while (bc->name != NULL && strcmp(bc->name, argv[i]) != 0)
+            bc++;
+        if (bc->name == NULL) {
+            printf("%s: unknown tool '%s'\n", PROGRAM_NAME, argv[i]);
+            usage(EXIT_FAILURE);
+        }
+    }
+
+    /* md and mkdir work in here */
+    const char *tmp = getenv("TMPDIR");
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s/ewe-bench.XXXXXX", tmp ? tmp : "/tmp");
+    if (mkdtemp(dir) == NULL) {
+        fprintf(stderr, "%s: cannot create a directory in '%s': %s\n", PROGRAM_NAME,
+            tmp ? tmp : "/tmp", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    FILE *out = stdout;
+    if (output != NULL && (out = fopen(output, "w")) == NULL) {
+        fprintf(stderr, "%s: cannot open '%s': %s\n", PROGRAM_NAME, output, strerror(errno));
+        rmdir(dir);
+        return EXIT_FAILURE;
+    }
+
+    struct utsname uts;
+    uname(&uts);
+
+    fprintf(out, "{\n  \"host\": {\"sysname\": ");
+    json_string(out, uts.sysname);
+    fprintf(out, ", \"release\": ");
+    json_string(out, uts.release);
+    fprintf(out, ", \"machine\": ");
+    json_string(out, uts.machine);
+    fprintf(out, ", \"cpus\": %ld},\n", sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(out, "  \"runs\": %zu,\n  \"warmup\": %zu,\n  \"tools\": [", runs, warmup);
+
+    bool first = true;
+    for (const struct bench_case *bc = cases; bc->name != NULL; bc++) {
+        if (!is_selected(bc->name, argc, argv))
+            continue;
+
+        struct bench_result *ewe = (struct bench_result *)calloc(1, sizeof(*ewe));
+        struct bench_result *gnu = (struct bench_result *)calloc(1, sizeof(*gnu));
+        if (ewe == NULL || gnu == NULL) {
+            fprintf(stderr, "%s: memory exhausted\n", PROGRAM_NAME);
+            return EXIT_FAILURE;
+        }
+
+        snprintf(ewe->path, sizeof(ewe->path), "%s/%s", ewe_dir, bc->name);
+        ewe->skipped = tool_skipped(ewe->path);
+        if (!with_gnu)
+            gnu->skipped = "not requested";
+        else if (!find_in_path(bc->gnu_name, gnu->path))
+            gnu->skipped = "not found";
+
+        fprintf(stderr, "%s:\n", bc->name);
+        if (ewe->skipped == NULL)
+            bench_tool(bc, ewe, dir, runs, warmup);
+        report_result("ewe", ewe);
+        if (with_gnu) {
+            if (gnu->skipped == NULL)
+                bench_tool(bc, gnu, dir, runs, warmup);
+            report_result("gnu", gnu);
+        }
+
+        fprintf(out, "%s\n    {\"name\": ", first ? "" : ",");
+        json_string(out, bc->name);
+        fprintf(out, ", \"args\": [");
+        for (size_t i = 0; i < 4 && bc->args[i] != NULL; i++) {
+            fprintf(out, "%s", i ? ", " : "");
+            json_string(out, bc->args[i]);
+        }
+        fprintf(out, "],\n      \"ewe\": ");
+        json_result(out, ewe);
+        if (with_gnu) {
+            fprintf(out, ",\n      \"gnu\": ");
+            json_result(out, gnu);
+        }
+        fprintf(out, "}");
+        first = false;
+
+        free(ewe->latency);
+        free(gnu->latency);
+        free(ewe);
+        free(gnu);
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    rmdir(dir);
+    if (out != stdout && fclose(out) != 0) {
+        fprintf(stderr, "%s: cannot write '%s': %s\n", PROGRAM_NAME, output, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,552 @@
+/* md -- check md against a reference mkdir
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* gcc -O2 bench/md.c -o bench/md */
+
+/* Usually for the md built from src/md.c:
+
+     gcc -O2 src/md.c -o /tmp/md -pthread src/include/xnanosleep.c
+     bench/md /tmp/md
+
+   Every case starts from an empty scratch directory holding its setup (some
+   directories and files), then runs both programs with the same arguments
+   in there, possibly under a lower limit of open files. They must both
+   succeed or both fail, and leave the same tree behind, or the exit status
+   is 1. The messages aren't compared, md words some of them differently.
+
+   Left out on purpose: a DIRECTORY that already exists (even as a file) is
+   no error to md.
+
+   Then every case, and a few more about the order of the operands, runs
+   through md once more with '--jobs', which must give the same messages,
+   exit status and tree as the serial run. */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#define PROGRAM_NAME "md"
+#define AUTHOR "netheround"
+
+#define COUNT(a) (sizeof(a) / sizeof(*(a)))
+
+/* mismatches printed before giving up on printing them */
+#define MAX_REPORTED 10
+
+/* replaced by a path of DEEP_LEVELS components, deeper than the open
+   files allowed to the run */
+#define DEEP_TOKEN "@DEEP@"
+#define DEEP_LEVELS 300
+
+static const char *reference_path = "/usr/bin/mkdir";
+static const char *program_path;
+
+static unsigned long checked, mismatches;
+
+/* where the runs happen, emptied between them */
+static char scratch[PATH_MAX];
+
+struct md_case
+{
+    /* made before the run, the directories with their parents */
+    const char *dirs[4];
+    const char *files[4];
+
+    const char *args[6];
+
+    /* RLIMIT_NOFILE of the run, 0 to leave it alone */
+    rlim_t nofile;
+};
+
+static const struct md_case cases[] = {
+    {{0}, {0}, {"x", "y"}, 0},
+    {{0}, {0}, {"a/b"}, 0},
+    {{0}, {0}, {"-p", "a/b/c"}, 0},
+    {{"a"}, {0}, {"-p", "a/b", "a/b/c/"}, 0},
+    {{0}, {0}, {"-p", "a//b///c//"}, 0},
+    {{0}, {0}, {"-p", "a/../b/./c"}, 0},
+    {{0}, {0}, {"-p", "p/q", "p/r/s", "p"}, 0},
+    {{"a"}, {"a/f"}, {"-p", "a/g", "a/f/x"}, 0},
+    {{0}, {"f"}, {"-p", "f/x/y"}, 0},
+
+    /* a failing DIRECTORY in the middle, the later ones are still made */
+    {{0}, {"f"}, {"-v", "a", "f/y", "b"}, 0},
+    {{0}, {"f"}, {"-v", "-p", "a/x", "f/y", "b"}, 0},
+    {{0}, {0}, {"-v", "n/a", "n"}, 0},
+
+    /* the cached parent fds stay under the limit */
+    {{0}, {0}, {"-p", DEEP_TOKEN}, 256},
+    {{0}, {0}, {"-p", DEEP_TOKEN "/c", DEEP_TOKEN "/d/e", "b/x"}, 256},
+    {{"b/b/b"}, {0}, {"-p", DEEP_TOKEN "/c"}, 128},
+};
+
+/* only md against itself: an existing directory is no error to md */
+static const struct md_case jobs_cases[] = {
+    {{0}, {0}, {"-v", "n", "n/a", "n/a/b"}, 0},
+    {{0}, {0}, {"-v", "a//b/", "a", "a/b"}, 0},
+    {{0}, {0}, {"-v", "x", "x", "y"}, 0},
+    {{0}, {0}, {"-v", "p", "q", "p/a", "q/b"}, 0},
+    {{0}, {"f"}, {"-v", "-p", "q/r", "f/x/y"}, 0},
+    {{0}, {0}, {"-v", "-p", "a/b/c", "a/d", "a"}, 0},
+};
+
+/* the flag md runs with the second time */
+#define JOBS_ARG "-j4"
+
+static void
+memory_exhausted (void)
+{
+    fprintf(stderr, "%s: memory exhausted\n", PROGRAM_NAME);
+    exit(EXIT_FAILURE);
+}
+
+/* the paths of a tree, one per line, sorted */
+struct tree
+{
+    char **paths;
+    size_t n;
+    size_t size;
+};
+
+/* nftw has no argument for its callback */
+static struct tree *listing;
+
+static int
+list_entry (const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+    (void)st;
+    (void)ftw;
+
+    /* the scratch directory itself */
+    if (path[strlen(scratch)] == '\0')
+        return 0;
+
+    if (listing->n == listing->size) {
+        listing->size = listing->size == 0 ? 64 : listing->size * 2;
+        listing->paths = (char **)realloc(listing->paths, listing->size * sizeof(*listing->paths));
+        if (listing->paths == NULL)
+            memory_exhausted();
+    }
+
+    /* "d " or "f ", then the path inside of the scratch directory */
+    const char *rel = path + strlen(scratch) + 1;
+    char *line = (char *)malloc(strlen(rel) + 3);
+    if (line == NULL)
+        memory_exhausted();
+    line[0] = type == FTW_D ? 'd' : 'f';
+    line[1] = ' ';
+    strcpy(line + 2, rel);
+
+    listing->paths[listing->n++] = line;
+    return 0;
+}
+
+static int
+path_cmp (const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void
+tree_list (struct tree *t)
+{
+    t->paths = NULL;
+    t->n = t->size = 0;
+    listing = t;
+    nftw(scratch, list_entry, 16, FTW_PHYS);
+    qsort(t->paths, t->n, sizeof(*t->paths), path_cmp);
+}
+
+static void
+tree_free (struct tree *t)
+{
+    for (size_t i = 0; i < t->n; i++)
+        free(t->paths[i]);
+    free(t->paths);
+}
+
+static int
+remove_entry (const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+    (void)st;
+    (void)type;
+    (void)ftw;
+
+    if (path[strlen(scratch)] != '\0')
+        remove(path);
+    return 0;
+}
+
+/* empties the scratch directory */
+static void
+scratch_clear (void)
+{
+    nftw(scratch, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static void
+setup (const struct md_case *mc)
+{
+    char path[PATH_MAX + 64];
+
+    scratch_clear();
+    for (size_t i = 0; i < COUNT(mc->dirs) && mc->dirs[i] != NULL; i++) {
+        /* one level at a time, like mkdir -p */
+        snprintf(path, sizeof(path), "%s/%s", scratch, mc->dirs[i]);
+        for (char *p = path + strlen(scratch) + 1; (p = strchr(p, '/')) != NULL; p++) {
+            *p = '\0';
+            mkdir(path, 0777);
+            *p = '/';
+        }
+        mkdir(path, 0777);
+    }
+
+    for (size_t i = 0; i < COUNT(mc->files) && mc->files[i] != NULL; i++) {
+        snprintf(path, sizeof(path), "%s/%s", scratch, mc->files[i]);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (fd != -1)
+            close(fd);
+    }
+}
+
+/* Runs PATH with ARGV in the scratch directory, its stdout and stderr to
+   OUT_FD (thrown away when it's -1), under NOFILE open files if it isn't 0.
+   Returns the exit status, 128 + the signal if it was killed. */
+static int
+run (const char *path, char **argv, rlim_t nofile, int out_fd)
+{
+    pid_t pid = fork();
+    if (pid == -1) {
+        fprintf(stderr, "%s: fork: %s\n", PROGRAM_NAME, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    if (pid == 0) {
+        if (out_fd == -1)
+            out_fd = open("/dev/null", O_WRONLY);
+        if (out_fd == -1 || chdir(scratch) != 0)
+            _exit(126);
+        dup2(out_fd, STDOUT_FILENO);
+        dup2(out_fd, STDERR_FILENO);
+
+        if (nofile != 0) {
+            struct rlimit rl = {nofile, nofile};
+            setrlimit(RLIMIT_NOFILE, &rl);
+        }
+        execv(path, argv);
+        _exit(127);
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            fprintf(stderr, "%s: waitpid: %s\n", PROGRAM_NAME, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+/* the arguments of MC, with DEEP_TOKEN expanded, after ARGV0 and FIRST
+   (unless it's NULL) */
+static char **
+case_argv (const struct md_case *mc, const char *argv0, const char *first)
+{
+    char **argv = (char **)calloc(COUNT(mc->args) + 3, sizeof(*argv));
+    if (argv == NULL)
+        memory_exhausted();
+
+    size_t n = 0;
+    argv[n++] = strdup(argv0);
+    if (first != NULL)
+        argv[n++] = strdup(first);
+
+    for (size_t i = 0; i < COUNT(mc->args) && mc->args[i] != NULL; i++) {
+        const char *arg = mc->args[i];
+        if (strncmp(arg, DEEP_TOKEN, strlen(DEEP_TOKEN)) != 0) {
+            argv[n++] = strdup(arg);
+            continue;
+        }
+
+        const char *rest = arg + strlen(DEEP_TOKEN);
+        char *deep = (char *)malloc(2 * DEEP_LEVELS + strlen(rest));
+        if (deep == NULL)
+            memory_exhausted();
+        for (size_t k = 0; k < DEEP_LEVELS; k++) {
+            deep[2 * k] = 'b';
+            deep[2 * k + 1] = '/';
+        }
+        strcpy(deep + 2 * DEEP_LEVELS - 1, rest);
+        argv[n++] = deep;
+    }
+    return argv;
+}
+
+static void
+argv_free (char **argv)
+{
+    for (size_t i = 0; argv[i] != NULL; i++)
+        free(argv[i]);
+    free(argv);
+}
+
+/* a temporary file the output of a run goes to */
+static int
+capture_open (void)
+{
+    FILE *f = tmpfile();
+    if (f == NULL) {
+        fprintf(stderr, "%s: cannot create a temporary file: %s\n", PROGRAM_NAME, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    return fileno(f);
+}
+
+/* reads back what FD holds, and empties it */
+static char *
+capture_take (int fd)
+{
+    off_t end = lseek(fd, 0, SEEK_END);
+    char *data = (char *)malloc(end > 0 ? (size_t)end + 1 : 1);
+    if (data == NULL)
+        memory_exhausted();
+
+    ssize_t n = end > 0 ? pread(fd, data, (size_t)end, 0) : 0;
+    data[n > 0 ? n : 0] = '\0';
+
+    if (ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0) {
+        fprintf(stderr, "%s: cannot truncate a temporary file: %s\n", PROGRAM_NAME, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    return data;
+}
+
+/* prints the arguments of MC, the deep path shortened */
+static void
+show_case (const struct md_case *mc)
+{
+    for (size_t i = 0; i < COUNT(mc->args) && mc->args[i] != NULL; i++)
+        printf(" %s", mc->args[i]);
+    if (mc->nofile != 0)
+        printf(" (at most %lu open files)", (unsigned long)mc->nofile);
+}
+
+/* the first line only in one of the trees, or NULL if they are the same */
+static const char *
+tree_diff (const struct tree *want, const struct tree *got, const char **which)
+{
+    size_t i = 0, j = 0;
+    while (i < want->n || j < got->n) {
+        int cmp = i == want->n ? 1 : j == got->n ? -1 : strcmp(want->paths[i], got->paths[j]);
+        if (cmp < 0) {
+            *which = "missing";
+            return want->paths[i];
+        }
+        if (cmp > 0) {
+            *which = "extra";
+            return got->paths[j];
+        }
+        i++;
+        j++;
+    }
+    return NULL;
+}
+
+static void
+check_case (const struct md_case *mc)
+{
+    char **ref_argv = case_argv(mc, "mkdir", NULL);
+    char **prog_argv = case_argv(mc, "md", NULL);
+    struct tree want, got;
+
+    setup(mc);
+    int want_status = run(reference_path, ref_argv, mc->nofile, -1);
+    tree_list(&want);
+
+    setup(mc);
+    int got_status = run(program_path, prog_argv, mc->nofile, -1);
+    tree_list(&got);
+    checked++;
+
+    const char *which;
+    const char *line = tree_diff(&want, &got, &which);
+    if ((line != NULL || (want_status == 0) != (got_status == 0)) && ++mismatches <= MAX_REPORTED) {
+        printf("mismatch: md");
+        show_case(mc);
+        if (line != NULL)
+            printf("\n  %s in the tree: %.72s%s\n", which, line, strlen(line) > 72 ? "..." : "");
+        else
+            printf("\n  exit status %d, not %d\n", got_status, want_status);
+    }
+
+    tree_free(&want);
+    tree_free(&got);
+    argv_free(ref_argv);
+    argv_free(prog_argv);
+}
+
+/* MC through md, serially and with JOBS_ARG */
+static void
+check_jobs (const struct md_case *mc, int out_fd)
+{
+    char **serial_argv = case_argv(mc, "md", NULL);
+    char **jobs_argv = case_argv(mc, "md", JOBS_ARG);
+    struct tree want, got;
+
+    setup(mc);
+    int want_status = run(program_path, serial_argv, mc->nofile, out_fd);
+    char *want_out = capture_take(out_fd);
+    tree_list(&want);
+
+    setup(mc);
+    int got_status = run(program_path, jobs_argv, mc->nofile, out_fd);
+    char *got_out = capture_take(out_fd);
+    tree_list(&got);
+    checked++;
+
+    const char *which;
+    const char *line = tree_diff(&want, &got, &which);
+    bool is_same_out = strcmp(want_out, got_out) == 0;
+    if ((line != NULL || !is_same_out || want_status != got_status) && ++mismatches <= MAX_REPORTED) {
+        printf("mismatch: md " JOBS_ARG);
+        show_case(mc);
+        if (line != NULL)
+            printf("\n  %s in the tree: %.72s%s\n", which, line, strlen(line) > 72 ? "..." : "");
+        else if (!is_same_out)
+            printf("\n  output:\n%s  not, serially:\n%s", got_out, want_out);
+        else
+            printf("\n  exit status %d, not %d\n", got_status, want_status);
+    }
+
+    free(want_out);
+    free(got_out);
+    tree_free(&want);
+    tree_free(&got);
+    argv_free(serial_argv);
+    argv_free(jobs_argv);
+}
+
+void
+usage (int status)
+{
+    if (status != EXIT_SUCCESS) {
+        printf("Try '%s --help' for more information.\n", PROGRAM_NAME);
+        exit(status);
+    }
+
+    printf("Usage: %s [OPTION]... PROGRAM\n"
+    "Check the directories the md PROGRAM creates against a reference mkdir.\n\n", PROGRAM_NAME);
+
+    puts("Options:\n"
+    "  --reference=PATH\tthe mkdir to compare with (default /usr/bin/mkdir)\n"
+    "  --help\tdisplay this help and exit\n"
+    "  --version\toutput version information and exit\n");
+    exit(status);
+}
+
+void
+version_info()
+{
+    printf("%s (EWE Coreutils) 0.0.1\n"
+    "Copyright (C) 2024\n"
+    "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
+    "This is free software: you are free to change and redistribute it.\n"
+    "\nWritten by %s\n", PROGRAM_NAME, AUTHOR);
+    exit(EXIT_SUCCESS);
+}
+
+enum
+{
+    REFERENCE_OPTION = CHAR_MAX + 1,
+    HELP_OPTION,
+    VERSION_OPTION
+};
+
+static struct option const long_options[] = {
+    {"reference", required_argument, 0, REFERENCE_OPTION},
+    {"help", no_argument, 0, HELP_OPTION},
+    {"version", no_argument, 0, VERSION_OPTION},
+
+    // terminating...
+    {0, 0, 0, 0}
+};
+
+int
+main (int argc, char **argv)
+{
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (c)
+        {
+            case REFERENCE_OPTION:
+                reference_path = optarg;
+                break;
+            case HELP_OPTION:
+                usage(EXIT_SUCCESS);
+                break;
+            case VERSION_OPTION:
+                version_info();
+                break;
+            default:
+                usage(EXIT_FAILURE);
+        }
+    }
+
+    if (optind != argc - 1) {
+        fprintf(stderr, optind == argc ? "%s: missing operand\n" : "%s: extra operand\n", PROGRAM_NAME);
+        usage(EXIT_FAILURE);
+    }
+
+    /* run by path from the scratch directory */
+    program_path = realpath(argv[optind], NULL);
+    if (program_path == NULL) {
+        fprintf(stderr, "%s: cannot find '%s': %s\n", PROGRAM_NAME, argv[optind], strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    const char *tmp = getenv("TMPDIR");
+    snprintf(scratch, sizeof(scratch), "%s/ewe-md.XXXXXX", tmp ? tmp : "/tmp");
+    if (mkdtemp(scratch) == NULL) {
+        fprintf(stderr, "%s: cannot create a directory in '%s': %s\n", PROGRAM_NAME,
+            tmp ? tmp : "/tmp", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < COUNT(cases); i++)
+        check_case(&cases[i]);
+
+    int out_fd = capture_open();
+    for (size_t i = 0; i < COUNT(cases); i++)
+        check_jobs(&cases[i], out_fd);
+    for (size_t i = 0; i < COUNT(jobs_cases); i++)
+        check_jobs(&jobs_cases[i], out_fd);
+
+    scratch_clear();
+    rmdir(scratch);
+
+    printf("%lu cases, %lu mismatches\n", checked, mismatches);
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
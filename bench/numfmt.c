@@ -0,0 +1,327 @@
+/* numfmt -- check the numfmt conversions against snprintf, and time both
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* gcc -O2 bench/numfmt.c -o bench/numfmt */
+
+/* First every directive of a corpus (the flags, widths and precisions
+   crossed with every conversion) formats random values both with the
+   kernels of src/include/numfmt.c and with snprintf, and the bytes must be
+   the same, or the exit status is 1. Then the usual directives are timed
+   both ways over the same values:
+
+     bench/numfmt -n 1000000 */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+#include <limits.h>
+#include <time.h>
+
+#include "../src/include/numfmt.c"
+
+#define PROGRAM_NAME "numfmt"
+#define AUTHOR "netheround"
+
+#define DEFAULT_VALUES 1000000
+#define CHECK_VALUES 2000
+
+/* mismatches printed before giving up on printing them */
+#define MAX_REPORTED 10
+
+/* the directives timed */
+static const char *const timed[] = {"d", "x", "o", "08d", "f", ".2f", "e", "g", ".10g"};
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t
+rng_next (void)
+{
+    /* xorshift64* */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/* integers of every length, not just the 19 digit ones */
+static uintmax_t
+random_integer (void)
+{
+    uint64_t bits = rng_next();
+    return (uintmax_t)(bits >> (rng_next() % 64));
+}
+
+/* what strtold makes of decimal input, and a few awkward values */
+static long double
+random_float (void)
+{
+    static const char *const special[] = {
+        "0", "-0", "0.5", "1.5", "2.5", "-0.5", "0.125", "0.375", "1e-5", "9.9999995",
+        "999999.5", "0.00001", "123456789012345678", "1e18", "9.5e-5", "0.1", "1e-300"
+    };
+    char buf[64];
+
+    switch (rng_next() % 4)
+    {
+        case 0:
+            return strtold(special[rng_next() % (sizeof(special) / sizeof(*special))], NULL);
+        case 1:
+            /* a double, exactly */
+            return (long double)((double)(int64_t)rng_next() / (double)(1ULL << (rng_next() % 63)));
+        default:
+            snprintf(buf, sizeof(buf), "%s%llu.%llue%d", rng_next() % 2 ? "-" : "",
+                (unsigned long long)(rng_next() % 1000000), (unsigned long long)(rng_next() % 100000),
+                (int)(rng_next() % 40) - 22);
+            return strtold(buf, NULL);
+    }
+}
+
+/* parses "%" FLAGS WIDTH "." PRECISION CONVERSION the way outf does. */
+static void
+parse_spec (const char *spec, struct numfmt *nf)
+{
+    memset(nf, 0, sizeof(*nf));
+    nf->precision = -1;
+
+    const char *p = spec;
+    for (; strchr("-+ #0", *p) != NULL && *p != '\0'; p++) {
+        switch (*p)
+        {
+            case '-': nf->flags |= NUMFMT_LEFT; break;
+            case '+': nf->flags |= NUMFMT_PLUS; break;
+            case ' ': nf->flags |= NUMFMT_SPACE; break;
+            case '#': nf->flags |= NUMFMT_ALT; break;
+            case '0': nf->flags |= NUMFMT_ZERO; break;
+        }
+    }
+    nf->width = (int)strtol(p, (char **)&p, 10);
+    if (*p == '.')
+        nf->precision = (int)strtol(p + 1, (char **)&p, 10);
+    nf->conversion = *p;
+}
+
+/* formats VALUE, an integer or a long double, with snprintf. */
+static int
+reference (char *buf, size_t size, const char *spec, uintmax_t i, long double x)
+{
+    char format[32];
+    bool is_float = strchr("aAeEfFgG", spec[strlen(spec) - 1]) != NULL;
+    snprintf(format, sizeof(format), "%%%.*s%s%c", (int)strlen(spec) - 1, spec,
+        is_float ? "L" : "j", spec[strlen(spec) - 1]);
+
+    if (is_float)
+        return snprintf(buf, size, format, x);
+    return snprintf(buf, size, format, i);
+}
+
+static size_t
+kernel (char *buf, const struct numfmt *nf, uintmax_t i, long double x)
+{
+    if (strchr("aAeEfFgG", nf->conversion) != NULL)
+        return numfmt_float(nf, x, buf);
+    return numfmt_integer(nf, i, buf);
+}
+
+/* checks every directive of the corpus, returns the number of mismatches. */
+static unsigned long
+check (void)
+{
+    static const char *const flags[] = {"", "-", "+", " ", "#", "0", "-+", "+0", " 0", "#0", "-#"};
+    static const char *const widths[] = {"", "1", "8", "25"};
+    static const char *const precisions[] = {"", ".0", ".1", ".3", ".6", ".12", ".18"};
+    static const char conversions[] = "diouxXfFeEgG";
+
+    unsigned long checked = 0, handled = 0, mismatches = 0;
+
+    for (size_t f = 0; f < sizeof(flags) / sizeof(*flags); f++)
+    for (size_t w = 0; w < sizeof(widths) / sizeof(*widths); w++)
+    for (size_t p = 0; p < sizeof(precisions) / sizeof(*precisions); p++)
+    for (const char *c = conversions; *c != '\0'; c++) {
+        char spec[32];
+        snprintf(spec, sizeof(spec), "%s%s%s%c", flags[f], widths[w], precisions[p], *c);
+
+        struct numfmt nf;
+        parse_spec(spec, &nf);
+
+        for (int n = 0; n < CHECK_VALUES; n++) {
+            uintmax_t i = random_integer();
+            long double x = random_float();
+            char want[512], got[NUMFMT_SIZE];
+
+            int want_len = reference(want, sizeof(want), spec, i, x);
+            size_t got_len = kernel(got, &nf, i, x);
+            checked++;
+            if (got_len == 0)
+                continue;
+
+            handled++;
+            if (got_len != (size_t)want_len || memcmp(got, want, got_len) != 0) {
+                if (++mismatches <= MAX_REPORTED)
+                    printf("mismatch: %%%s of %.21Lg: '%s', not '%.*s'\n", spec,
+                        strchr("aAeEfFgG", *c) ? x : (long double)i, want, (int)got_len, got);
+            }
+        }
+    }
+
+    printf("checked %lu conversions, %lu by the kernels, %lu mismatches\n",
+        checked, handled, mismatches);
+    return mismatches;
+}
+
+static double
+seconds_since (const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* times NVALUES conversions of every directive of `timed` both ways. */
+static void
+bench (size_t nvalues)
+{
+    uintmax_t *ints = (uintmax_t *)malloc(nvalues * sizeof(*ints));
+    long double *floats = (long double *)malloc(nvalues * sizeof(*floats));
+    if (ints == NULL || floats == NULL) {
+        fprintf(stderr, "%s: memory exhausted\n", PROGRAM_NAME);
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t n = 0; n < nvalues; n++) {
+        ints[n] = random_integer();
+        floats[n] = random_float();
+    }
+
+    printf("\n%-10s %12s %12s %9s\n", "directive", "snprintf", "numfmt", "speedup");
+    for (size_t t = 0; t < sizeof(timed) / sizeof(*timed); t++) {
+        struct numfmt nf;
+        parse_spec(timed[t], &nf);
+
+        char buf[512];
+        volatile size_t sink = 0;
+
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t n = 0; n < nvalues; n++)
+            sink += (size_t)reference(buf, sizeof(buf), timed[t], ints[n], floats[n]);
+        double libc = seconds_since(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t n = 0; n < nvalues; n++) {
+            size_t len = kernel(buf, &nf, ints[n], floats[n]);
+            /* what outf does when the kernel can't */
+            if (len == 0)
+                len = (size_t)reference(buf, sizeof(buf), timed[t], ints[n], floats[n]);
+            sink += len;
+        }
+        double ours = seconds_since(&start);
+
+        char name[16];
+        snprintf(name, sizeof(name), "%%%s", timed[t]);
+        printf("%-10s %9.1f ns %9.1f ns %8.1fx\n", name, libc * 1e9 / (double)nvalues,
+            ours * 1e9 / (double)nvalues, libc / ours);
+    }
+
+    free(ints);
+    free(floats);
+}
+
+void
+usage (int status)
+{
+    if (status != EXIT_SUCCESS) {
+        printf("Try '%s --help' for more information.\n", PROGRAM_NAME);
+        exit(status);
+    }
+
+    printf("Usage: %s [OPTION]...\n"
+    "Check the numfmt conversions against snprintf, then time both.\n\n", PROGRAM_NAME);
+
+    puts("Options:\n"
+    "  -n VALUES\tvalues formatted per timed directive (default 1000000)\n"
+    "  --check\tonly check, don't time\n"
+    "  --help\tdisplay this help and exit\n"
+    "  --version\toutput version information and exit\n");
+    exit(status);
+}
+
+void
+version_info()
+{
+    printf("%s (EWE Coreutils) 0.0.1\n"
+    "Copyright (C) 2024\n"
+    "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
+    "This is free software: you are free to change and redistribute it.\n"
+    "\nWritten by %s\n", PROGRAM_NAME, AUTHOR);
+    exit(EXIT_SUCCESS);
+}
+
+enum
+{
+    CHECK_OPTION = CHAR_MAX + 1,
+    HELP_OPTION,
+    VERSION_OPTION
+};
+
+static struct option const long_options[] = {
+    {"check", no_argument, 0, CHECK_OPTION},
+    {"help", no_argument, 0, HELP_OPTION},
+    {"version", no_argument, 0, VERSION_OPTION},
+
+    // terminating...
+    {0, 0, 0, 0}
+};
+
+int
+main (int argc, char **argv)
+{
+    size_t nvalues = DEFAULT_VALUES;
+    bool is_check_only = false;
+
+    int c;
+    while ((c = getopt_long(argc, argv, "n:", long_options, NULL)) != -1) {
+        switch (c)
+        {
+            case 'n': {
+                char *end;
+                nvalues = strtoul(optarg, &end, 10);
+                if (*end != '\0' || nvalues == 0) {
+                    fprintf(stderr, "%s: invalid number of values: '%s'\n", PROGRAM_NAME, optarg);
+                    usage(EXIT_FAILURE);
+                }
+                break;
+            }
+            case CHECK_OPTION:
+                is_check_only = true;
+                break;
+            case HELP_OPTION:
+                usage(EXIT_SUCCESS);
+                break;
+            case VERSION_OPTION:
+                version_info();
+                break;
+            default:
+                usage(EXIT_FAILURE);
+        }
+    }
+
+    if (check() != 0)
+        return EXIT_FAILURE;
+    if (!is_check_only)
+        bench(nvalues);
+    return EXIT_SUCCESS;
+}
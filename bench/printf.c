@@ -0,0 +1,743 @@
+/* printf -- check a printf against a reference one, byte for byte, and time both
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* gcc -O2 bench/printf.c -o bench/printf */
+
+/* Usually for the printf built from src/gnu/printf.c:
+
+     (cd src && gcc -O2 -I include/gnulib gnu/printf.c -o printf)
+     bench/printf src/printf
+
+   First a corpus of formats (the flags, widths and precisions crossed with
+   every conversion, the escapes, %b and %q over awkward arguments, and the
+   malformed directives) runs through both programs, in the C locale and in
+   a UTF-8 one, and the output, the messages and the exit status must be the
+   same, or the exit status is 1. Then every class of directive is timed in
+   both over the same arguments, in megabytes of output per second; a run
+   writes a megabyte or more, so the process startup is mostly amortized. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <getopt.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+#define PROGRAM_NAME "printf"
+#define AUTHOR "netheround"
+
+#define DEFAULT_RUNS 20
+
+/* mismatches printed before giving up on printing them */
+#define MAX_REPORTED 10
+
+/* bytes of a format or argument shown in a mismatch */
+#define SHOW_MAX 72
+
+/* both programs are run as "printf", so that their messages can be compared */
+#define RUN_NAME "printf"
+
+static const char *const locales[] = {"C", "C.UTF-8"};
+
+static const char *reference_path = "/usr/bin/printf";
+static const char *program_path;
+
+static unsigned long checked, mismatches;
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t
+rng_next (void)
+{
+    /* xorshift64* */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static void
+memory_exhausted (void)
+{
+    fprintf(stderr, "%s: memory exhausted\n", PROGRAM_NAME);
+    exit(EXIT_FAILURE);
+}
+
+/* an argument vector, always null terminated, starting with RUN_NAME */
+struct args
+{
+    char **v;
+    size_t n;
+    size_t size;
+};
+
+static void
+args_add_len (struct args *a, const char *s, size_t len)
+{
+    if (a->n + 2 > a->size) {
+        a->size = a->size == 0 ? 64 : a->size * 2;
+        a->v = (char **)realloc(a->v, a->size * sizeof(*a->v));
+        if (a->v == NULL)
+            memory_exhausted();
+    }
+
+    char *copy = (char *)malloc(len + 1);
+    if (copy == NULL)
+        memory_exhausted();
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+
+    a->v[a->n++] = copy;
+    a->v[a->n] = NULL;
+}
+
+static void
+args_add (struct args *a, const char *s)
+{
+    args_add_len(a, s, strlen(s));
+}
+
+static void
+args_init (struct args *a, const char *format)
+{
+    a->v = NULL;
+    a->n = a->size = 0;
+    args_add(a, RUN_NAME);
+    args_add(a, format);
+}
+
+static void
+args_free (struct args *a)
+{
+    for (size_t i = 0; i < a->n; i++)
+        free(a->v[i]);
+    free(a->v);
+}
+
+/* a growing string, for the formats and the long arguments */
+struct text
+{
+    char *data;
+    size_t len;
+    size_t size;
+};
+
+static void
+text_add (struct text *t, const char *s)
+{
+    size_t len = strlen(s);
+    if (t->len + len + 1 > t->size) {
+        t->size = (t->len + len + 1) * 2;
+        t->data = (char *)realloc(t->data, t->size);
+        if (t->data == NULL)
+            memory_exhausted();
+    }
+    memcpy(t->data + t->len, s, len + 1);
+    t->len += len;
+}
+
+/* the output of a run, read back from a temporary file */
+struct capture
+{
+    int fd;
+    char *data;
+    size_t len;
+    size_t size;
+};
+
+static void
+capture_init (struct capture *c)
+{
+    FILE *f = tmpfile();
+    if (f == NULL) {
+        fprintf(stderr, "%s: cannot create a temporary file: %s\n", PROGRAM_NAME, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    c->fd = fileno(f);
+    c->data = NULL;
+    c->len = c->size = 0;
+}
+
+static void
+capture_reset (struct capture *c)
+{
+    if (ftruncate(c->fd, 0) != 0 || lseek(c->fd, 0, SEEK_SET) != 0) {
+        fprintf(stderr, "%s: cannot truncate a temporary file: %s\n", PROGRAM_NAME, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void
+capture_read (struct capture *c)
+{
+    off_t end = lseek(c->fd, 0, SEEK_END);
+    if (end < 0)
+        end = 0;
+
+    if ((size_t)end + 1 > c->size) {
+        c->size = (size_t)end + 1;
+        c->data = (char *)realloc(c->data, c->size);
+        if (c->data == NULL)
+            memory_exhausted();
+    }
+
+    size_t done = 0;
+    while (done < (size_t)end) {
+        ssize_t n = pread(c->fd, c->data + done, (size_t)end - done, (off_t)done);
+        if (n <= 0)
+            break;
+        done += (size_t)n;
+    }
+    c->len = done;
+}
+
+/* Runs PATH with ARGV under LC_ALL=LOCALE and nothing else in the
+   environment, stdout to OUT_FD and stderr to ERR_FD. Returns the exit
+   status, 128 + the signal if it was killed. */
+static int
+run (const char *path, char **argv, const char *locale, int out_fd, int err_fd)
+{
+    char lc_all[64];
+    snprintf(lc_all, sizeof(lc_all), "LC_ALL=%s", locale);
+    char *envp[] = {lc_all, NULL};
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err_fd, STDERR_FILENO);
+
+    pid_t pid;
+    int err = posix_spawn(&pid, path, &actions, NULL, argv, envp);
+    posix_spawn_file_actions_destroy(&actions);
+    if (err != 0) {
+        fprintf(stderr, "%s: cannot run '%s': %s\n", PROGRAM_NAME, path, strerror(err));
+        exit(EXIT_FAILURE);
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            fprintf(stderr, "%s: waitpid: %s\n", PROGRAM_NAME, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+/* prints the first SHOW_MAX bytes of S, with C escapes */
+static void
+show (const char *s, size_t len)
+{
+    putchar('"');
+    for (size_t i = 0; i < len && i < SHOW_MAX; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\')
+            printf("\\%c", c);
+        else if (c >= ' ' && c < 0x7F)
+            putchar(c);
+        else
+            printf("\\%03o", c);
+    }
+    printf(len > SHOW_MAX ? "\"..." : "\"");
+}
+
+static struct capture ref_out, ref_err, prog_out, prog_err;
+
+static void
+report (const char *what, const char *locale, const struct args *a, const char *stream,
+    const struct capture *want, const struct capture *got)
+{
+    if (++mismatches > MAX_REPORTED)
+        return;
+
+    printf("mismatch: %s, LC_ALL=%s, format ", what, locale);
+    show(a->v[1], strlen(a->v[1]));
+    printf(" with %zu arguments\n  %s of the reference: ", a->n - 2, stream);
+    show(want->data, want->len);
+    printf("\n  %s of the program:   ", stream);
+    show(got->data, got->len);
+    putchar('\n');
+}
+
+/* Runs A through both programs in every locale, and compares. */
+static void
+check_case (const char *what, const struct args *a)
+{
+    for (size_t l = 0; l < sizeof(locales) / sizeof(*locales); l++) {
+        capture_reset(&ref_out);
+        capture_reset(&ref_err);
+        capture_reset(&prog_out);
+        capture_reset(&prog_err);
+
+        int want = run(reference_path, a->v, locales[l], ref_out.fd, ref_err.fd);
+        int got = run(program_path, a->v, locales[l], prog_out.fd, prog_err.fd);
+        capture_read(&ref_out);
+        capture_read(&ref_err);
+        capture_read(&prog_out);
+        capture_read(&prog_err);
+        checked++;
+
+        if (ref_out.len != prog_out.len || memcmp(ref_out.data, prog_out.data, ref_out.len) != 0)
+            report(what, locales[l], a, "stdout", &ref_out, &prog_out);
+        else if (ref_err.len != prog_err.len || memcmp(ref_err.data, prog_err.data, ref_err.len) != 0)
+            report(what, locales[l], a, "stderr", &ref_err, &prog_err);
+        else if (want != got && ++mismatches <= MAX_REPORTED) {
+            printf("mismatch: %s, LC_ALL=%s, format ", what, locales[l]);
+            show(a->v[1], strlen(a->v[1]));
+            printf(": exit status %d, not %d\n", got, want);
+        }
+    }
+}
+
+static const char *const flags[] = {"", "-", "+", " ", "#", "0", "-+", "+0", " 0", "#0", "-#", "'"};
+static const char *const widths[] = {"", "1", "8", "*"};
+static const char *const star_widths[] = {"6", "-9", "0", "1"};
+static const char *const star_precisions[] = {"2", "-1", "0", "7"};
+
+static const char *const integers[] = {
+    "0", "1", "-1", "42", "-42", "255", "65535", "2147483648", "-9223372036854775808",
+    "18446744073709551615", "99999999999999999999", "0x1F", "-0X7f", "0755", "08", "'A",
+    "\"\xc3\xa9", "' ", "'", "+7", " 12", "1x", "", "abc", "1234567"
+};
+
+static const char *const floats[] = {
+    "0", "-0", "1", "0.5", "1.5", "2.5", "-2.5", "3.14159265358979", "1e-5", "123456789",
+    "1e300", "-1e-300", "1e4932", "0x1.8p3", "inf", "-inf", "nan", "1,5", "'a", "9.9999995",
+    "0.000123456789", "999999.5", "1e6", "x", "1e-320"
+};
+
+static const char *const strings[] = {
+    "", "a", "abc def", "tab\there", "quote'd", "it's", "dq\"", "back\\slash",
+    "\\101\\x41\\0101\\u00e9", "x\\cy", "\xc3\xa9\xe2\x82\xac", "\x01\x7f", "\xff\x80",
+    "#h", "a#", "~", "{", "}", "{}", "a=b", "$HOME", "\\", "\\x", "\\U0001F600", "\\e\\E",
+    "\\0", "\\08", "\\1234", "new\nline", "-n", "'", "'\x01"
+};
+
+#define COUNT(array) (sizeof(array) / sizeof(*(array)))
+
+/* Every flag, width and precision of PRECISIONS with CONVERSION, in one
+   format, over every value of VALUES. */
+static void
+check_directives (char conversion, const char *const *precisions, size_t nprecisions,
+    const char *const *values, size_t nvalues)
+{
+    for (size_t f = 0; f < COUNT(flags); f++) {
+        struct text format = {0};
+        for (size_t w = 0; w < COUNT(widths); w++) {
+            for (size_t p = 0; p < nprecisions; p++) {
+                char directive[32];
+                snprintf(directive, sizeof(directive), "%%%s%s%s%c|", flags[f], widths[w],
+                    precisions[p], conversion);
+                text_add(&format, directive);
+            }
+        }
+        text_add(&format, "\n");
+
+        struct args a;
+        args_init(&a, format.data);
+        for (size_t v = 0; v < nvalues; v++) {
+            for (size_t w = 0; w < COUNT(widths); w++) {
+                for (size_t p = 0; p < nprecisions; p++) {
+                    if (widths[w][0] == '*')
+                        args_add(&a, star_widths[(v + p) % COUNT(star_widths)]);
+                    if (strcmp(precisions[p], ".*") == 0)
+                        args_add(&a, star_precisions[(v + w) % COUNT(star_precisions)]);
+                    args_add(&a, values[v]);
+                }
+            }
+        }
+
+        char what[32];
+        snprintf(what, sizeof(what), "%%%c, flags '%s'", conversion, flags[f]);
+        check_case(what, &a);
+        args_free(&a);
+        free(format.data);
+    }
+}
+
+static void
+check_conversions (void)
+{
+    static const char *const int_precisions[] = {"", ".0", ".3", ".*"};
+    static const char *const float_precisions[] = {"", ".0", ".1", ".3", ".10", ".*"};
+    static const char *const string_precisions[] = {"", ".0", ".2", ".*"};
+
+    for (const char *c = "diouxX"; *c != '\0'; c++)
+        check_directives(*c, int_precisions, COUNT(int_precisions), integers, COUNT(integers));
+    for (const char *c = "fFeEgGaA"; *c != '\0'; c++)
+        check_directives(*c, float_precisions, COUNT(float_precisions), floats, COUNT(floats));
+    for (const char *c = "sbqc"; *c != '\0'; c++)
+        check_directives(*c, string_precisions, COUNT(string_precisions), strings, COUNT(strings));
+}
+
+/* not \u0041 and the like: coreutils before 9.2 rejects the code points
+   below U+00A0 */
+static const char *const escapes[] = {
+    "\\\\", "\\a", "\\b", "\\c", "\\e", "\\f", "\\n", "\\r", "\\t", "\\v", "\\\"", "\\'",
+    "\\?", "\\z", "\\0", "\\7", "\\101", "\\0101", "\\1234", "\\400", "\\x", "\\x4", "\\x41",
+    "\\x414", "\\xg", "\\u00e9", "\\u20ac", "\\u0024", "\\u00a0", "\\U0001F600", "\\U00110000",
+    "\\ud800", "\\uDFFF", "\\u12", "\\U1234567", "\\", "%%", "%", "plain ", "\xc3\xa9"
+};
+
+/* the escapes of the format, alone and then strung together */
+static void
+check_escapes (void)
+{
+    for (size_t e = 0; e < COUNT(escapes); e++) {
+        struct text format = {0};
+        text_add(&format, "a");
+        text_add(&format, escapes[e]);
+        text_add(&format, "b%s\n");
+
+        struct args a;
+        args_init(&a, format.data);
+        args_add(&a, "x");
+        args_add(&a, "y");
+        check_case("escape", &a);
+        args_free(&a);
+        free(format.data);
+    }
+
+    for (int n = 0; n < 300; n++) {
+        struct text format = {0};
+        int nescapes = 1 + (int)(rng_next() % 6);
+        for (int i = 0; i < nescapes; i++) {
+            text_add(&format, escapes[rng_next() % COUNT(escapes)]);
+            if (rng_next() % 2)
+                text_add(&format, rng_next() % 2 ? "%s" : "%b");
+        }
+
+        struct args a;
+        args_init(&a, format.data);
+        for (int i = 0; i < 3; i++)
+            args_add(&a, strings[rng_next() % COUNT(strings)]);
+        check_case("escapes", &a);
+        args_free(&a);
+        free(format.data);
+    }
+}
+
+/* The directives printf rejects or takes in its own way. Not the widths
+   past INT_MAX: those fail in vprintf, which the gnulib replacement of a
+   configured coreutils reports as a write error, and glibc's doesn't. */
+static void
+check_malformed (void)
+{
+    static const char *const formats[] = {
+        "%", "%z", "%5", "%-", "%.", "%*", "%ld", "%hhd", "%Lf", "%jd", "%zd", "%td", "%lld",
+        "%'d", "%I", "%#s", "%0c", "%+s", "%5%", "%%", "x%", "%1$d", "%-5.3q", "%.*.*d", "%y",
+        "%*.*d", "%--5d", "%.-3d", "%#q", "% s", "%.3c",
+        "%5.2s%c", "%s\\c%s", "%b\\"
+    };
+
+    for (size_t f = 0; f < COUNT(formats); f++) {
+        struct args a;
+        args_init(&a, formats[f]);
+        args_add(&a, "1");
+        args_add(&a, "2");
+        args_add(&a, "3");
+        check_case("malformed", &a);
+        args_free(&a);
+
+        /* and without arguments */
+        args_init(&a, formats[f]);
+        check_case("malformed", &a);
+        args_free(&a);
+    }
+}
+
+static unsigned long
+check (void)
+{
+    capture_init(&ref_out);
+    capture_init(&ref_err);
+    capture_init(&prog_out);
+    capture_init(&prog_err);
+
+    check_conversions();
+    check_escapes();
+    check_malformed();
+
+    printf("checked %lu runs against %s, %lu mismatches\n", checked, reference_path, mismatches);
+    return mismatches;
+}
+
+/* the classes of directive timed */
+enum workload
+{
+    LITERAL,
+    ESCAPES,
+    INTEGER,
+    HEX,
+    FIXED,
+    GENERAL,
+    STRING,
+    PADDED,
+    CHARACTER,
+    ESCAPED_STRING,
+    SHELL_SAFE,
+    SHELL_QUOTED
+};
+
+static const struct
+{
+    enum workload kind;
+    const char *name;
+    const char *format;
+} workloads[] = {
+    {LITERAL, "literal", NULL},
+    {ESCAPES, "escapes", NULL},
+    {INTEGER, "%d", "%d\n"},
+    {HEX, "%08x", "%08x "},
+    {FIXED, "%.3f", "%.3f\n"},
+    {GENERAL, "%g", "%g\n"},
+    {STRING, "%s", "%s\n"},
+    {PADDED, "%-12s", "%-12s|"},
+    {CHARACTER, "%c", "%c"},
+    {ESCAPED_STRING, "%b", "%b\n"},
+    {SHELL_SAFE, "%q safe", "%q\n"},
+    {SHELL_QUOTED, "%q quoted", "%q\n"}
+};
+
+/* long arguments: few enough to stay far from ARG_MAX */
+#define LONG_ARGS 48
+#define LONG_ARG_SIZE 16384
+
+/* short arguments, a pointer and a few bytes each */
+#define SHORT_ARGS 40000
+
+/* text of LONG_ARG_SIZE bytes, with PIECE over and over */
+static void
+long_text (struct text *t, const char *piece)
+{
+    while (t->len + strlen(piece) < LONG_ARG_SIZE)
+        text_add(t, piece);
+}
+
+static void
+build_workload (enum workload kind, const char *format, struct args *a)
+{
+    static const char *const words[] = {"a", "printf", "of", "ewe", "coreutils", "x", "directive"};
+    struct text t = {0};
+    char buf[64];
+
+    switch (kind)
+    {
+        case LITERAL:
+        case ESCAPES:
+            /* the format is used again for every argument %.0s takes */
+            long_text(&t, kind == LITERAL ? "The quick brown fox jumps over the lazy dog.\n"
+                : "tab\\tbell\\a\\101\\x42\\0103\\\\\\n");
+            text_add(&t, "%.0s");
+            args_init(a, t.data);
+            for (int i = 0; i < LONG_ARGS * 8; i++)
+                args_add(a, "");
+            break;
+        case INTEGER:
+        case HEX:
+        case CHARACTER:
+            args_init(a, format);
+            for (int i = 0; i < SHORT_ARGS; i++) {
+                uint64_t r = rng_next();
+                if (kind == CHARACTER)
+                    snprintf(buf, sizeof(buf), "%c", 'a' + (int)(r % 26));
+                else
+                    snprintf(buf, sizeof(buf), "%lld", (long long)(int64_t)r >> (r % 48));
+                args_add(a, buf);
+            }
+            break;
+        case FIXED:
+        case GENERAL:
+            args_init(a, format);
+            for (int i = 0; i < SHORT_ARGS; i++) {
+                snprintf(buf, sizeof(buf), "%.6e", (double)(int64_t)rng_next() / (double)(1ULL << (rng_next() % 63)));
+                args_add(a, buf);
+            }
+            break;
+        case PADDED:
+            args_init(a, format);
+            for (int i = 0; i < SHORT_ARGS; i++)
+                args_add(a, words[rng_next() % COUNT(words)]);
+            break;
+        case STRING:
+        case ESCAPED_STRING:
+        case SHELL_SAFE:
+        case SHELL_QUOTED:
+            long_text(&t, kind == STRING ? "some text, with punctuation; and spaces! "
+                : kind == ESCAPED_STRING ? "some text\\twith\\101 escapes\\n"
+                : kind == SHELL_SAFE ? "path/to/some-file_name.txt:"
+                : "it's a \"quoted\" $argument ");
+            args_init(a, format);
+            for (int i = 0; i < LONG_ARGS; i++)
+                args_add(a, t.data);
+            break;
+    }
+    free(t.data);
+}
+
+static double
+seconds_since (const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* megabytes per second of RUNS runs of PATH, each writing BYTES */
+static double
+throughput (const char *path, const struct args *a, size_t bytes, int runs, int null_fd)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < runs; r++)
+        run(path, a->v, "C", null_fd, null_fd);
+    return (double)bytes * runs / seconds_since(&start) / 1e6;
+}
+
+static void
+bench (int runs)
+{
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd == -1) {
+        fprintf(stderr, "%s: cannot open /dev/null: %s\n", PROGRAM_NAME, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    printf("\n%-10s %9s %12s %12s %8s\n", "class", "output", "reference", "program", "ratio");
+    for (size_t w = 0; w < COUNT(workloads); w++) {
+        struct args a;
+        build_workload(workloads[w].kind, workloads[w].format, &a);
+
+        /* the output is checked once more, and sized */
+        check_case(workloads[w].name, &a);
+        size_t bytes = ref_out.len;
+
+        double want = throughput(reference_path, &a, bytes, runs, null_fd);
+        double got = throughput(program_path, &a, bytes, runs, null_fd);
+        printf("%-10s %6.2f MB %7.1f MB/s %7.1f MB/s %7.2fx\n", workloads[w].name,
+            (double)bytes / 1e6, want, got, got / want);
+        args_free(&a);
+    }
+    close(null_fd);
+}
+
+void
+usage (int status)
+{
+    if (status != EXIT_SUCCESS) {
+        printf("Try '%s --help' for more information.\n", PROGRAM_NAME);
+        exit(status);
+    }
+
+    printf("Usage: %s [OPTION]... PROGRAM\n"
+    "Check the output of the printf PROGRAM against a reference printf, then time both.\n\n", PROGRAM_NAME);
+
+    puts("Options:\n"
+    "  -n RUNS\truns of each timed class of directive (default 20)\n"
+    "  --reference=PATH\tthe printf to compare with (default /usr/bin/printf)\n"
+    "  --check\tonly check, don't time\n"
+    "  --help\tdisplay this help and exit\n"
+    "  --version\toutput version information and exit\n");
+    exit(status);
+}
+
+void
+version_info()
+{
+    printf("%s (EWE Coreutils) 0.0.1\n"
+    "Copyright (C) 2024\n"
+    "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
+    "This is free software: you are free to change and redistribute it.\n"
+    "\nWritten by %s\n", PROGRAM_NAME, AUTHOR);
+    exit(EXIT_SUCCESS);
+}
+
+enum
+{
+    REFERENCE_OPTION = CHAR_MAX + 1,
+    CHECK_OPTION,
+    HELP_OPTION,
+    VERSION_OPTION
+};
+
+static struct option const long_options[] = {
+    {"reference", required_argument, 0, REFERENCE_OPTION},
+    {"check", no_argument, 0, CHECK_OPTION},
+    {"help", no_argument, 0, HELP_OPTION},
+    {"version", no_argument, 0, VERSION_OPTION},
+
+    // terminating...
+    {0, 0, 0, 0}
+};
+
+int
+main (int argc, char **argv)
+{
+    int runs = DEFAULT_RUNS;
+    bool is_check_only = false;
+
+    int c;
+    while ((c = getopt_long(argc, argv, "n:", long_options, NULL)) != -1) {
+        switch (c)
+        {
+            case 'n': {
+                char *end;
+                long n = strtol(optarg, &end, 10);
+                if (*end != '\0' || n <= 0 || n > INT_MAX) {
+                    fprintf(stderr, "%s: invalid number of runs: '%s'\n", PROGRAM_NAME, optarg);
+                    usage(EXIT_FAILURE);
+                }
+                runs = (int)n;
+                break;
+            }
+            case REFERENCE_OPTION:
+                reference_path = optarg;
+                break;
+            case CHECK_OPTION:
+                is_check_only = true;
+                break;
+            case HELP_OPTION:
+                usage(EXIT_SUCCESS);
+                break;
+            case VERSION_OPTION:
+                version_info();
+                break;
+            default:
+                usage(EXIT_FAILURE);
+        }
+    }
+
+    if (optind != argc - 1) {
+        fprintf(stderr, optind == argc ? "%s: missing operand\n" : "%s: extra operand\n", PROGRAM_NAME);
+        usage(EXIT_FAILURE);
+    }
+    program_path = argv[optind];
+
+    if (check() != 0)
+        return EXIT_FAILURE;
+    if (!is_check_only) {
+        bench(runs);
+        if (mismatches != 0)
+            return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/* builtins -- the EWE Coreutils as loadable bash builtins
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* gcc -shared -fPIC -I/usr/include/bash -I/usr/include/bash/include -I/usr/include/bash/builtins builtins.c -o ewe.so -pthread ./include/xnanosleep.c */
+
+/* Load them into a running shell with:
+
+     enable -f ./ewe.so md cwd tt true false
+
+   after which `md -p a/b` is a function call instead of a fork and exec.
+   Each builtin runs the same `<tool>_run` the executables do; those keep
+   their options in locals, rewind getopt and return instead of exiting,
+   so they can run any number of times in the same process. */
+
+#include "include/tools.c"
+
+#include "loadables.h"
+
+/* runs a tool with LIST as its arguments, NAME being its argv[0]. */
+static int
+run_builtin (int (*run) (int, char **), WORD_LIST *list)
+{
+    int argc;
+    char **argv = make_builtin_argv(list, &argc);
+    if (argv == NULL)
+        return EXECUTION_FAILURE;
+
+    /* whatever the shell buffered must come out before the tool writes */
+    fflush(stdout);
+    int status = run(argc, argv);
+    fflush(stdout);
+    fflush(stderr);
+
+    xfree(argv);
+    return status;
+}
+
+/* bash already has `true_builtin` and `false_builtin`, hence the prefix. */
+
+int
+ewe_md_builtin (WORD_LIST *list)
+{
+    md_name = "md";
+    return run_builtin(md_run, list);
+}
+
+int
+ewe_cwd_builtin (WORD_LIST *list)
+{
+    return run_builtin(cwd_run, list);
+}
+
+int
+ewe_tt_builtin (WORD_LIST *list)
+{
+    return run_builtin(tt_run, list);
+}
+
+int
+ewe_true_builtin (WORD_LIST *list)
+{
+    return run_builtin(true_run, list);
+}
+
+int
+ewe_false_builtin (WORD_LIST *list)
+{
+    return run_builtin(false_run, list);
+}
+
+char *md_doc[] = {
+    "Create directories.",
+    "",
+    "Create the DIRECTORY(ies), if they do not already exist.",
+    "See `md --help' for the options.",
+    (char *)NULL
+};
+
+char *cwd_doc[] = {
+    "Print the current working directory.",
+    "",
+    "See `cwd --help' for the options.",
+    (char *)NULL
+};
+
+char *tt_doc[] = {
+    "Print the terminal connected to standard input.",
+    "",
+    "See `tt --help' for the options.",
+    (char *)NULL
+};
+
+char *true_doc[] = {
+    "Do nothing, successfully.",
+    "",
+    "Exit with a status code indicating success.",
+    (char *)NULL
+};
+
+char *false_doc[] = {
+    "Do nothing, unsuccessfully.",
+    "",
+    "Exit with a status code indicating failure.",
+    (char *)NULL
+};
+
+struct builtin md_struct = {
+    "md",
+    ewe_md_builtin,
+    BUILTIN_ENABLED,
+    md_doc,
+    "md [OPTION]... DIRECTORY...",
+    0
+};
+
+struct builtin cwd_struct = {
+    "cwd",
+    ewe_cwd_builtin,
+    BUILTIN_ENABLED,
+    cwd_doc,
+    "cwd [OPTION]...",
+    0
+};
+
+struct builtin tt_struct = {
+    "tt",
+    ewe_tt_builtin,
+    BUILTIN_ENABLED,
+    tt_doc,
+    "tt [OPTION]...",
+    0
+};
+
+struct builtin true_struct = {
+    "true",
+    ewe_true_builtin,
+    BUILTIN_ENABLED,
+    true_doc,
+    "true [ignored command line arguments]",
+    0
+};
+
+struct builtin false_struct = {
+    "false",
+    ewe_false_builtin,
+    BUILTIN_ENABLED,
+    false_doc,
+    "false [ignored command line arguments]",
+    0
+};
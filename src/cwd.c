@@ -25,6 +25,8 @@
 #include <string.h>
 #include <errno.h>
 
+#include "include/config.h"
+
 /* definitions */
 #define PROGRAM_NAME "cwd"
 #define AUTHOR "netheround"
@@ -46,20 +48,21 @@
 
 /* options */
 
-/* flag set by '--help, --version'. */
-static int verbose_flag;
-
-/* logical, physical modes, read more: https://en.wikipedia.org/wiki/Pwd */
-static bool is_logical = false;
+/* long options without a short equivalent. */
+enum
+{
+    HELP_OPTION = CHAR_MAX + 1,
+    VERSION_OPTION
+};
 
-static struct option long_options[] = {
+static struct option const long_options[] = {
     /* these options set a flag. */
     {"physical", no_argument, 0, 'P'},
     {"logical", no_argument, 0, 'L'},
 
     /* these options don't set a flag. */
-    {"help", no_argument, &verbose_flag, 1},
-    {"version", no_argument, &verbose_flag, 2},
+    {"help", no_argument, 0, HELP_OPTION},
+    {"version", no_argument, 0, VERSION_OPTION},
 
     // terminating...
     {0, 0, 0, 0}
@@ -67,12 +70,12 @@ static struct option long_options[] = {
 
 // ...
 
-void
+int
 usage (int status)
 {
    if (status != EXIT_SUCCESS) {
         printf("Try '%s --help' for more information.\n", PROGRAM_NAME);
-        exit(status);
+        return status;
     }
 
    printf("Usage %s [OPTION]...\n"
@@ -89,10 +92,10 @@ usage (int status)
    printf("Examples:\n"
    "  %s -L    -> print the current working directory using PWD.\n"
    "  %s       -> print the current working directory.\n", PROGRAM_NAME, PROGRAM_NAME);
-   exit(status);
+   return status;
 }
 
-void
+int
 version_info()
 {
     printf("%s (EWE Coreutils) 0.0.1\n"
@@ -100,36 +103,34 @@ version_info()
     "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
     "This is free software: you are free to change and redistribute it.\n"
     "\nWritten by %s\n", PROGRAM_NAME, AUTHOR);
-    exit(EXIT_SUCCESS);
+    return EXIT_SUCCESS;
 }
 
+/* logical, physical modes, read more: https://en.wikipedia.org/wiki/Pwd */
 char*
-get_curent_directory()
+get_curent_directory(bool is_logical)
 {
-   char *buf = (char *)malloc(PATH_MAX * sizeof(char));
-   if (buf == NULL) {
-      fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
-      return NULL;
-   }
-   
    char *cwd;
    if (is_logical) {
       cwd = getenv("PWD");
       if (cwd == NULL) {
          fprintf(stderr, "%s: 'PWD' environment variable not found.\n", PROGRAM_NAME);
-         exit(EXIT_FAILURE);
-
-         free(buf);
          return NULL;
       }
 
       /* Duplicate the string to ensure it's writable */
       cwd = strdup(cwd);
       if (cwd == NULL) {
+         fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
          return NULL;
-         free(buf);
       }
    } else {
+      char *buf = (char *)malloc(PATH_MAX * sizeof(char));
+      if (buf == NULL) {
+         fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+         return NULL;
+      }
+
       cwd = getcwd(buf, PATH_MAX);
       if (cwd == NULL) {
          free(buf);
@@ -140,10 +141,16 @@ get_curent_directory()
    return cwd;
 }
 
+/* Runs cwd with ARGV and returns its exit status, without ever exiting. */
 int
-main (int argc, char **argv)
+cwd_run (int argc, char **argv)
 {
+   /* flag set by '--help, --version'. */
+   int verbose_flag = 0;
+   bool is_logical = false;
+
    int c;
+   reset_getopt();
    while (true) {
       int option_ind = 0;
       c = getopt_long(argc, argv, "LP", long_options, &option_ind);
@@ -153,13 +160,13 @@ main (int argc, char **argv)
       
       switch (c)
       {
-         case 0:
-            if (long_options[option_ind].flag != 0)
-                    break;
-                printf("option %s", long_options[option_ind].name);
-                if (optarg)
-                    printf(" with arg %s\n", optarg);
-                break;
+         case HELP_OPTION:
+            verbose_flag = 1;
+            break;
+
+         case VERSION_OPTION:
+            verbose_flag = 2;
+            break;
          
          case 'L':
             is_logical = true;
@@ -172,25 +179,24 @@ main (int argc, char **argv)
          case '?':
             /* getopt_long aleardy printed an error message. */
 
-            usage(EXIT_FAILURE);
-            break;
+            return usage(EXIT_FAILURE);
          
          default:
-            usage(2);
+            return usage(2);
       }
    };
 
    switch (verbose_flag)
    {
       case 1:
-         usage(EXIT_SUCCESS);
+         return usage(EXIT_SUCCESS);
       case 2:
-         version_info();
+         return version_info();
    }
 
    /* main logic */
 
-   char *cwd = get_curent_directory();
+   char *cwd = get_curent_directory(is_logical);
    if (cwd == NULL) {
       fprintf(stderr, "%s: error fetching current working directory: %s", PROGRAM_NAME, strerror(errno));
       return EXIT_FAILURE;
@@ -201,4 +207,10 @@ main (int argc, char **argv)
 
    return EXIT_SUCCESS;
    // ...
-}
\ No newline at end of file
+}
+
+int
+main (int argc, char **argv)
+{
+   return cwd_run(argc, argv);
+}
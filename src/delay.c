@@ -20,8 +20,6 @@
 
 TODO:
 
-don't allow `delay -0s`
-add verbose option that prints every second
 Make it cross platform by using Sleep on windows.
 
 */
@@ -33,12 +31,104 @@ Make it cross platform by using Sleep on windows.
 #include <errno.h>
 #include <string.h>
 #include <locale.h>
+#include <getopt.h>
+#include <limits.h>
+#include <time.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+#ifdef __linux__
+# include <sys/prctl.h>
+# include <sys/timerfd.h>
+#endif /* __linux__ */
 
 #include "include/xnanosleep.h"
 
 #define PROGRAM_NAME "delay"
 #define AUTHOR "netheround"
 
+/* how long before the deadline --precise stops sleeping and spins. */
+#define PRECISE_SPIN 50e-6
+
+/* --calibrate: the sleeps of a bucket take about this long in total,
+   with at least CALIBRATE_MIN_SAMPLES and at most --count samples. */
+#define CALIBRATE_BUDGET 2.0
+#define CALIBRATE_MIN_SAMPLES 3
+#define CALIBRATE_SAMPLES 1000
+
+/* --progress redraws this often, and its bar is this wide */
+#define PROGRESS_PERIOD 1.0
+#define PROGRESS_WIDTH 20
+
+/* options */
+
+/* long options without a short equivalent. */
+enum
+{
+    PRECISE_OPTION = CHAR_MAX + 1,
+    EVERY_OPTION,
+    UNTIL_OPTION,
+    COUNT_OPTION,
+    OVERRUN_OPTION,
+    CALIBRATE_OPTION,
+    PROGRESS_OPTION,
+    HELP_OPTION,
+    VERSION_OPTION
+};
+
+static struct option const long_options[] = {
+    {"precise", no_argument, 0, PRECISE_OPTION},
+    {"every", required_argument, 0, EVERY_OPTION},
+    {"until", required_argument, 0, UNTIL_OPTION},
+    {"sync-at", required_argument, 0, UNTIL_OPTION},
+    {"count", required_argument, 0, COUNT_OPTION},
+    {"overrun", required_argument, 0, OVERRUN_OPTION},
+    {"calibrate", no_argument, 0, CALIBRATE_OPTION},
+    {"progress", no_argument, 0, PROGRESS_OPTION},
+    {"help", no_argument, 0, HELP_OPTION},
+    {"version", no_argument, 0, VERSION_OPTION},
+
+    // terminating...
+    {0, 0, 0, 0}
+};
+
+/* what --every does with the ticks that passed while the command ran */
+enum overrun_policy
+{
+    /* run once for the latest tick, the others are missed */
+    OVERRUN_SKIP,
+    /* run once for every tick, late, back to back */
+    OVERRUN_CATCH_UP
+};
+
+struct delay_options
+{
+    /* sleep coarsely, then spin the last PRECISE_SPIN seconds */
+    bool is_precise;
+
+    /* --until TIME, on CLOCK_REALTIME */
+    bool has_until;
+    struct timespec until;
+
+    /* --every INTERVAL in seconds, 0 without it */
+    double every;
+    /* runs of the command, 0 for no limit */
+    unsigned long count;
+    enum overrun_policy overrun;
+
+    /* measure the overshoot of every way to sleep instead */
+    bool is_calibrate;
+
+    /* count down on the terminal */
+    bool is_progress;
+};
+
+extern char **environ;
+
+/* set by SIGINT and SIGTERM while --every runs */
+static volatile sig_atomic_t is_stopping;
+
 void
 usage (int status)
 {
@@ -48,18 +138,46 @@ usage (int status)
     }
 
     printf("Usage: %s NUMBER[SUFFIX]...\n"
-    "  or:  %s OPTION\n", PROGRAM_NAME, PROGRAM_NAME);
+    "  or:  %s --calibrate [--count N] [NUMBER[SUFFIX]]...\n"
+    "  or:  %s --until TIME\n"
+    "  or:  %s [--until TIME] --every NUMBER[SUFFIX] [--count N] [--overrun POLICY] -- COMMAND [ARG]...\n"
+    "  or:  %s OPTION\n", PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME);
 
     puts("Pause for NUMBER seconds.  SUFFIX may be 's' for seconds (the default),\n"
     "'m' for minutes, 'h' for hours or 'd' for days.  NUMBER need not be an\n"
     "integer.  Given two or more arguments, pause for the amount of time\n"
     "specified by the sum of their values.\n\n"
+    "With --every, run COMMAND at a fixed rate instead: every NUMBER[SUFFIX] on\n"
+    "the monotonic clock, however long COMMAND takes, until it ran N times or\n"
+    "delay is interrupted.  Missed ticks are reported on standard error.\n\n"
+    "With --until, pause until TIME on the wall clock, following any step of it;\n"
+    "the last microseconds are spun so that processes waiting for the same TIME\n"
+    "wake up within microseconds of each other.  TIME is @SECONDS[.FRACTION]\n"
+    "since the epoch, or YYYY-MM-DDTHH:MM[:SS[.FRACTION]] followed by 'Z' or an\n"
+    "offset like '+02:00', in local time without one.  Given --every too, the\n"
+    "ticks start at TIME.\n\n"
+    "      --until=TIME, --sync-at=TIME\n"
+    "\t\t\tpause until TIME\n\n"
+    "With --calibrate, sleep up to N times (1000 by default) for each NUMBER, or\n"
+    "for 1us to 1s, with every way delay can sleep, and print how late each\n"
+    "woke up (p50, p99 and p99.9, in microseconds) as JSON.\n\n"
+    "      --every=INTERVAL\trun COMMAND every INTERVAL\n"
+    "      --count=N\t\tstop after running COMMAND N times\n"
+    "      --overrun=POLICY\twhen COMMAND outlasts a tick, run it once and 'skip'\n"
+    "\t\t\tthe other ticks that passed (the default), or 'catch-up'\n"
+    "\t\t\tby running it once for each of them\n"
+    "      --progress\t\tcount down on standard output, if it is a terminal\n"
+    "      --precise\t\tspin the last microseconds instead of sleeping them,\n"
+    "\t\t\tto wake up within a few microseconds of the deadline\n"
     "      --help\t\tdisplay this help and exit\n"
     "      --version\t\toutput version information and exit\n");
 
     printf("Examples:\n"
     "  %s 1h 30m    -> pauses for 1 hour and 30 minutes.\n"
-    "  %s 10        -> pauses for 10 seconds.\n", PROGRAM_NAME, PROGRAM_NAME);
+    "  %s 10        -> pauses for 10 seconds.\n"
+    "  %s --every 1 -- date  -> prints the date every second, without drifting.\n"
+    "  %s --until 2026-10-17T12:00:00Z  -> pauses until noon UTC.\n",
+    PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME);
     exit(status);
 }
 
@@ -104,43 +222,709 @@ apply_suffix (double *x, char suffix)
     return true;
 }
 
+/* parses NUMBER[SUFFIX] into SECONDS. */
+static bool
+parse_interval (const char *arg, double *seconds)
+{
+    char *endptr;
+    errno = 0;
+    double s = strtod(arg, &endptr);
+
+    if (endptr == arg || errno == ERANGE
+        /* nonnegative interval */
+        || !(0 <= s)
+        /* no extra chars after the number and an optional s,m,h,d char. */
+        || (*endptr && *(endptr + 1))
+        /* check any sufix char and update 's' based on sufix. */
+        || !apply_suffix(&s, *endptr))
+        return false;
+
+    *seconds = s;
+    return true;
+}
+
+/* reads exactly N digits at *P into VALUE. */
+static bool
+parse_digits (const char **p, int n, int *value)
+{
+    *value = 0;
+    for (int i = 0; i < n; i++, (*p)++) {
+        if (**p < '0' || **p > '9')
+            return false;
+        *value = *value * 10 + (**p - '0');
+    }
+    return true;
+}
+
+/* reads .FRACTION at *P, if any, into nanoseconds (digits past 9 ignored). */
+static bool
+parse_fraction (const char **p, long *nsec)
+{
+    *nsec = 0;
+    if (**p != '.' && **p != ',')
+        return true;
+
+    (*p)++;
+    if (**p < '0' || **p > '9')
+        return false;
+
+    long scale = 100000000;
+    for (; **p >= '0' && **p <= '9'; (*p)++) {
+        *nsec += (**p - '0') * scale;
+        scale /= 10;
+    }
+    return true;
+}
+
+/* parses --until TIME, see usage(). */
+static bool
+parse_until (const char *arg, struct timespec *ts)
+{
+    const char *p = arg;
+
+    if (*p == '@') {
+        char *endptr;
+        p++;
+        if (*p < '0' || *p > '9')
+            return false;
+
+        errno = 0;
+        long long sec = strtoll(p, &endptr, 10);
+        p = endptr;
+        if (errno == ERANGE || (time_t)sec != sec || !parse_fraction(&p, &ts->tv_nsec) || *p)
+            return false;
+
+        ts->tv_sec = (time_t)sec;
+        return true;
+    }
+
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    if (!parse_digits(&p, 4, &tm.tm_year) || *p++ != '-'
+        || !parse_digits(&p, 2, &tm.tm_mon) || *p++ != '-'
+        || !parse_digits(&p, 2, &tm.tm_mday)
+        || (*p != 'T' && *p != 't' && *p != ' ') || !*p++
+        || !parse_digits(&p, 2, &tm.tm_hour) || *p++ != ':'
+        || !parse_digits(&p, 2, &tm.tm_min))
+        return false;
+
+    long nsec = 0;
+    if (*p == ':' && (p++, !parse_digits(&p, 2, &tm.tm_sec) || !parse_fraction(&p, &nsec)))
+        return false;
+
+    if (tm.tm_mon < 1 || tm.tm_mon > 12 || tm.tm_mday < 1 || tm.tm_mday > 31
+        || tm.tm_hour > 23 || tm.tm_min > 59 || tm.tm_sec > 60)
+        return false;
+
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+
+    time_t t;
+    if (*p == '\0') {
+        /* local time */
+        tm.tm_isdst = -1;
+        t = mktime(&tm);
+    } else {
+        long offset = 0;
+        if (*p == 'Z' || *p == 'z') {
+            p++;
+        } else if (*p == '+' || *p == '-') {
+            int sign = *p++ == '-' ? -1 : 1, hours, minutes = 0;
+            if (!parse_digits(&p, 2, &hours))
+                return false;
+            if (*p == ':')
+                p++;
+            if (*p && !parse_digits(&p, 2, &minutes))
+                return false;
+            offset = sign * (hours * 3600L + minutes * 60L);
+        }
+        if (*p)
+            return false;
+        t = timegm(&tm) - offset;
+    }
+
+    if (t == (time_t)-1)
+        return false;
+
+    ts->tv_sec = t;
+    ts->tv_nsec = nsec;
+    return true;
+}
+
 static void
-parse_cli_args (int argc, char **argv)
+parse_cli_args (int argc, char **argv, struct delay_options *opts)
 {
-    if (argc == 1) {
-        printf("%s: missing operand\n", PROGRAM_NAME);
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (c)
+        {
+            case PRECISE_OPTION:
+                opts->is_precise = true;
+                break;
+
+            case EVERY_OPTION:
+                /* the timer ticks in nanoseconds, less would be a one-shot */
+                if (!parse_interval(optarg, &opts->every) || opts->every < 1e-9) {
+                    fprintf(stderr, "%s: invalid time interval '%s'\n", PROGRAM_NAME, optarg);
+                    usage(EXIT_FAILURE);
+                }
+                break;
+
+            case UNTIL_OPTION:
+                if (!parse_until(optarg, &opts->until)) {
+                    fprintf(stderr, "%s: invalid time '%s'\n", PROGRAM_NAME, optarg);
+                    usage(EXIT_FAILURE);
+                }
+                opts->has_until = true;
+                break;
+
+            case CALIBRATE_OPTION:
+                opts->is_calibrate = true;
+                break;
+
+            case PROGRESS_OPTION:
+                opts->is_progress = true;
+                break;
+
+            case COUNT_OPTION: {
+                char *endptr;
+                errno = 0;
+                opts->count = strtoul(optarg, &endptr, 10);
+                if (endptr == optarg || *endptr || errno == ERANGE || opts->count == 0
+                    || optarg[0] == '-') {
+                    fprintf(stderr, "%s: invalid count '%s'\n", PROGRAM_NAME, optarg);
+                    usage(EXIT_FAILURE);
+                }
+                break;
+            }
+
+            case OVERRUN_OPTION:
+                if (strcmp(optarg, "skip") == 0) {
+                    opts->overrun = OVERRUN_SKIP;
+                } else if (strcmp(optarg, "catch-up") == 0) {
+                    opts->overrun = OVERRUN_CATCH_UP;
+                } else {
+                    fprintf(stderr, "%s: invalid overrun policy '%s'\n", PROGRAM_NAME, optarg);
+                    usage(EXIT_FAILURE);
+                }
+                break;
+
+            case HELP_OPTION:
+                usage(EXIT_SUCCESS);
+                break;
+
+            case VERSION_OPTION:
+                version_info();
+                break;
+
+            default:
+                /* getopt_long aleardy printed an error message. */
+                usage(EXIT_FAILURE);
+        }
+    }
+
+    if (opts->has_until && !opts->every && optind < argc) {
+        printf("%s: extra operand '%s'\n", PROGRAM_NAME, argv[optind]);
+        usage(EXIT_FAILURE);
+    }
+
+    if (optind == argc && (opts->every || !(opts->has_until || opts->is_calibrate))) {
+        printf("%s: missing %s\n", PROGRAM_NAME, opts->every ? "command" : "operand");
         usage(EXIT_FAILURE);
     }
 
-    if (strcmp(argv[1], "--help") == 0) {
-        usage(EXIT_SUCCESS);
-    } else if (strcmp(argv[1], "--version") == 0) {
-        version_info();
+    if (opts->is_calibrate && (opts->every || opts->has_until)) {
+        printf("%s: '--calibrate' can't be used with '--every' or '--until'\n", PROGRAM_NAME);
+        usage(EXIT_FAILURE);
+    }
+
+    if (opts->is_progress && (opts->every || opts->has_until || opts->is_calibrate)) {
+        printf("%s: '--progress' only applies to pausing for NUMBER[SUFFIX]\n", PROGRAM_NAME);
+        usage(EXIT_FAILURE);
+    }
+
+    if (opts->every == 0 && opts->overrun != OVERRUN_SKIP) {
+        printf("%s: '--overrun' only applies to '--every'\n", PROGRAM_NAME);
+        usage(EXIT_FAILURE);
+    }
+
+    if (opts->every == 0 && !opts->is_calibrate && opts->count) {
+        printf("%s: '--count' only applies to '--every' and '--calibrate'\n", PROGRAM_NAME);
+        usage(EXIT_FAILURE);
     }
 }
 
+/* the default 50us of timer slack would make coarse sleeps overshoot */
+static void
+reduce_timer_slack (void)
+{
+#if defined(__linux__) && defined(PR_SET_TIMERSLACK)
+    prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+#endif
+}
+
+/* sleeps SECONDS, in the way OPTS asks for. */
+static int
+delay_for (double seconds, const struct delay_options *opts)
+{
+    if (!opts->is_precise)
+        return xnanosleep(seconds);
+
+    reduce_timer_slack();
+    return xnanosleep_spin(seconds, PRECISE_SPIN);
+}
+
+/* one write per redraw, stdout's buffer is never involved */
+static bool
+put_progress (const char *line, size_t len)
+{
+    return write(STDOUT_FILENO, line, len) == (ssize_t)len;
+}
+
+/* draws "delay: H:MM:SS left [####      ]  40%" over the current line. */
+static void
+draw_progress (double left, double total)
+{
+    /* a whole second is shown until it's over: 10, 9, ..., 1 */
+    unsigned long secs = (unsigned long)left;
+    if ((double)secs < left)
+        secs++;
+
+    int done = total > 0 ? (int)((total - left) / total * 100) : 100;
+    int filled = done * PROGRESS_WIDTH / 100;
+
+    char bar[PROGRESS_WIDTH + 1];
+    memset(bar, ' ', PROGRESS_WIDTH);
+    memset(bar, '#', (size_t)filled);
+    bar[PROGRESS_WIDTH] = '\0';
+
+    char line[128];
+    int len = snprintf(line, sizeof(line), "\r%s: %lu:%02lu:%02lu left [%s] %3d%%\033[K",
+        PROGRAM_NAME, secs / 3600, secs / 60 % 60, secs % 60, bar, done);
+
+    if (len > 0)
+        put_progress(line, (size_t)len);
+}
+
+/* --progress: sleeps SECONDS like delay_for, redrawing the time left at
+   every PROGRESS_PERIOD since the start. Every redraw sleeps toward an
+   absolute deadline and the last one toward the end itself, so the time
+   spent drawing never adds up: the whole pause takes exactly SECONDS. */
+static int
+delay_progress (double seconds, const struct delay_options *opts)
+{
+    if (!isatty(STDOUT_FILENO))
+        return delay_for(seconds, opts);
+
+    double spin = 0;
+    if (opts->is_precise) {
+        reduce_timer_slack();
+        spin = PRECISE_SPIN;
+    }
+
+    struct timespec start, end, now;
+    if (clock_gettime(XNANOSLEEP_CLOCK, &start) != 0)
+        return -1;
+    end = start;
+    xtimespec_add(&end, seconds);
+
+    int status = 0;
+    for (now = start; ; clock_gettime(XNANOSLEEP_CLOCK, &now)) {
+        double left = xtimespec_diff(&now, &end);
+        if (left <= 0)
+            break;
+        draw_progress(left, seconds);
+
+        /* the next whole period since the start, even after a stop (^Z) */
+        double elapsed = xtimespec_diff(&start, &now);
+        struct timespec next = start;
+        xtimespec_add(&next, ((unsigned long)(elapsed / PROGRESS_PERIOD) + 1) * PROGRESS_PERIOD);
+
+        if (xtimespec_diff(&next, &end) <= 0) {
+            status = xnanosleep_until(XNANOSLEEP_CLOCK, &end, spin);
+            break;
+        }
+        if ((status = xnanosleep_until(XNANOSLEEP_CLOCK, &next, 0)) != 0)
+            break;
+    }
+
+    /* leave the line as it was */
+    put_progress("\r\033[K", 4);
+    return status;
+}
+
+/* sleeps until --until. CLOCK_REALTIME is read again after every wake-up
+   (and the kernel moves absolute CLOCK_REALTIME timers when the clock is
+   set), so a step of the clock in between is followed. */
+static int
+delay_until (const struct timespec *until)
+{
+    reduce_timer_slack();
+    return xnanosleep_until(CLOCK_REALTIME, until, PRECISE_SPIN);
+}
+
+static void
+stop_handler (int sig)
+{
+    (void)sig;
+    is_stopping = 1;
+}
+
+/* the ticks of --every: START + k * INTERVAL for k = 1, 2, ... */
+struct ticker
+{
+    struct timespec start;
+    double interval;
+    /* the last tick that passed */
+    unsigned long tick;
+    int fd;
+    double spin;
+};
+
+static int
+ticker_init (struct ticker *t, double interval, double spin)
+{
+    t->interval = interval;
+    t->tick = 0;
+    t->spin = spin;
+    t->fd = -1;
+    if (clock_gettime(XNANOSLEEP_CLOCK, &t->start) != 0)
+        return -1;
+
+#if defined(__linux__) && defined(TFD_TIMER_ABSTIME)
+    /* the kernel keeps the ticks on the grid and counts the ones we miss;
+       spinning needs the clock in our hands, though. */
+    if (spin == 0) {
+        t->fd = timerfd_create(XNANOSLEEP_CLOCK, TFD_CLOEXEC);
+        if (t->fd == -1)
+            return -1;
+
+        struct itimerspec its;
+        its.it_value = t->start;
+        xtimespec_add(&its.it_value, interval);
+        its.it_interval.tv_sec = (time_t)interval;
+        its.it_interval.tv_nsec = (long)((interval - (time_t)interval) * 1e9);
+        /* a zero interval would disarm the timer after its first tick */
+        if (its.it_interval.tv_sec == 0 && its.it_interval.tv_nsec == 0)
+            its.it_interval.tv_nsec = 1;
+        return timerfd_settime(t->fd, TFD_TIMER_ABSTIME, &its, NULL);
+    }
+#endif /* __linux__ */
+    return 0;
+}
+
+/* the deadline of tick K. */
+static struct timespec
+ticker_deadline (const struct ticker *t, unsigned long k)
+{
+    struct timespec deadline = t->start;
+    xtimespec_add(&deadline, (double)k * t->interval);
+    return deadline;
+}
+
+/* waits for the next tick, returns how many ticks passed (at least 1),
+   0 once interrupted, -1 on failure. */
+static long
+ticker_wait (struct ticker *t)
+{
+    unsigned long passed;
+
+    if (t->fd != -1) {
+        unsigned long long expirations;
+        if (read(t->fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            return (errno == EINTR && is_stopping) ? 0 : -1;
+        passed = (unsigned long)expirations;
+    } else {
+        struct timespec next = ticker_deadline(t, t->tick + 1);
+        if (xnanosleep_until_stoppable(XNANOSLEEP_CLOCK, &next, t->spin, &is_stopping) != 0)
+            return (errno == EINTR && is_stopping) ? 0 : -1;
+
+        struct timespec now;
+        clock_gettime(XNANOSLEEP_CLOCK, &now);
+        passed = (unsigned long)(xtimespec_diff(&t->start, &now) / t->interval) - t->tick;
+        if (passed == 0)
+            passed = 1;
+    }
+
+    if (is_stopping)
+        return 0;
+
+    t->tick += passed;
+    return (long)passed;
+}
+
+/* runs ARGV and waits for it, returns its exit status like a shell would. */
+static int
+run_command (char **argv)
+{
+    pid_t pid;
+    int err = posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ);
+    if (err != 0) {
+        fprintf(stderr, "%s: cannot run '%s': %s\n", PROGRAM_NAME, argv[0], strerror(err));
+        return err == ENOENT ? 127 : 126;
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) == -1)
+        if (errno != EINTR)
+            return EXIT_FAILURE;
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+/* --every: runs ARGV on every tick, returns the status of its last run. */
+static int
+run_every (char **argv, const struct delay_options *opts)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_handler;
+    sigemptyset(&sa.sa_mask);
+    /* no SA_RESTART: the wait for the next tick has to end */
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    double spin = 0;
+    if (opts->is_precise) {
+        reduce_timer_slack();
+        spin = PRECISE_SPIN;
+    }
+
+    struct ticker t;
+    if (ticker_init(&t, opts->every, spin) != 0) {
+        fprintf(stderr, "%s: cannot set up a timer: %s\n", PROGRAM_NAME, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    unsigned long runs = 0, missed = 0, late = 0;
+    double worst = 0;
+    int status = EXIT_SUCCESS;
+
+    /* ticks due and not run yet, the first one is right away */
+    unsigned long pending = 1;
+    unsigned long next_tick = 0;
+
+    while (!is_stopping) {
+        for (; pending > 0 && !is_stopping; pending--, next_tick++) {
+            struct timespec deadline = ticker_deadline(&t, next_tick), now;
+            clock_gettime(XNANOSLEEP_CLOCK, &now);
+
+            double lateness = xtimespec_diff(&deadline, &now);
+            if (lateness > worst)
+                worst = lateness;
+            if (next_tick < t.tick)
+                late++;
+
+            status = run_command(argv);
+            runs++;
+            if (status == 126 || status == 127 || (opts->count && runs == opts->count))
+                goto done;
+        }
+
+        long passed = ticker_wait(&t);
+        if (passed <= 0) {
+            if (passed == -1) {
+                fprintf(stderr, "%s: cannot wait for the next tick: %s\n", PROGRAM_NAME, strerror(errno));
+                status = EXIT_FAILURE;
+            }
+            break;
+        }
+
+        if (opts->overrun == OVERRUN_SKIP) {
+            missed += (unsigned long)passed - 1;
+            pending = 1;
+            next_tick = t.tick;
+        } else {
+            pending = t.tick - next_tick + 1;
+        }
+    }
+
+done:
+    if (t.fd != -1)
+        close(t.fd);
+
+    fprintf(stderr, "%s: %lu runs in %lu ticks, %lu missed, %lu late, started at most %.3fms late\n",
+        PROGRAM_NAME, runs, t.tick + 1, missed, late, worst * 1e3);
+    return status;
+}
+
+/* --calibrate */
+
+enum sleep_strategy
+{
+    /* relative nanosleep, what xnanosleep used to do */
+    SLEEP_NANOSLEEP,
+    /* clock_nanosleep(TIMER_ABSTIME) toward one deadline, plain delay */
+    SLEEP_ABSOLUTE,
+    /* a one-shot timerfd, like --every */
+    SLEEP_TIMERFD,
+    /* an absolute sleep and a spin, --precise (and --until) */
+    SLEEP_SPIN,
+    SLEEP_STRATEGIES
+};
+
+static const char *const strategy_names[SLEEP_STRATEGIES] = {
+    "nanosleep", "clock_nanosleep", "timerfd", "spin"
+};
+
+/* sleeps SECONDS with STRATEGY, LATE is how late it woke up. */
+static bool
+calibrate_once (enum sleep_strategy strategy, double seconds, int tfd, double *late)
+{
+    struct timespec start, deadline, end;
+    struct timespec rel = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+
+    clock_gettime(XNANOSLEEP_CLOCK, &start);
+    deadline = start;
+    xtimespec_add(&deadline, seconds);
+
+    switch (strategy)
+    {
+        case SLEEP_NANOSLEEP:
+            if (nanosleep(&rel, NULL) != 0)
+                return false;
+            break;
+
+        case SLEEP_ABSOLUTE:
+        case SLEEP_SPIN:
+            if (xnanosleep_until(XNANOSLEEP_CLOCK, &deadline,
+                strategy == SLEEP_SPIN ? PRECISE_SPIN : 0) != 0)
+                return false;
+            break;
+
+        case SLEEP_TIMERFD: {
+#if defined(__linux__) && defined(TFD_TIMER_ABSTIME)
+            struct itimerspec its = {{0, 0}, deadline};
+            unsigned long long expirations;
+            if (timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL) != 0
+                || read(tfd, &expirations, sizeof(expirations)) != sizeof(expirations))
+                return false;
+#else
+            (void)tfd;
+            return false;
+#endif
+            break;
+        }
+
+        default:
+            return false;
+    }
+
+    clock_gettime(XNANOSLEEP_CLOCK, &end);
+    *late = xtimespec_diff(&deadline, &end);
+    return true;
+}
+
+static int
+cmp_double (const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* nearest-rank percentile of the sorted V */
+static double
+percentile (const double *v, size_t n, double p)
+{
+    size_t rank = (size_t)(p / 100.0 * (double)n + 0.999999);
+    if (rank < 1)
+        rank = 1;
+    if (rank > n)
+        rank = n;
+    return v[rank - 1];
+}
+
+/* --calibrate: sleeps each of the NDURATIONS DURATIONS with every strategy,
+   prints the overshoot percentiles as JSON. */
+static int
+calibrate (const double *durations, size_t ndurations, unsigned long max_samples)
+{
+    int tfd = -1;
+#if defined(__linux__) && defined(TFD_TIMER_ABSTIME)
+    tfd = timerfd_create(XNANOSLEEP_CLOCK, TFD_CLOEXEC);
+#endif
+
+    long slack_ns = -1;
+#if defined(__linux__) && defined(PR_GET_TIMERSLACK)
+    slack_ns = prctl(PR_GET_TIMERSLACK, 0UL, 0UL, 0UL, 0UL);
+#endif
+
+    double *samples = (double *)malloc(max_samples * sizeof(double));
+    if (samples == NULL) {
+        fprintf(stderr, "%s: memory exhausted\n", PROGRAM_NAME);
+        return EXIT_FAILURE;
+    }
+
+    printf("{\n  \"clock\": \"%s\",\n  \"timer_slack_ns\": %ld,\n  \"strategies\": [",
+        XNANOSLEEP_CLOCK == CLOCK_REALTIME ? "CLOCK_REALTIME" : "CLOCK_MONOTONIC", slack_ns);
+
+    /* the spin is last: it lowers the timer slack of the whole process */
+    for (int strategy = 0; strategy < SLEEP_STRATEGIES; strategy++) {
+        if (strategy == SLEEP_TIMERFD && tfd == -1)
+            continue;
+        if (strategy == SLEEP_SPIN)
+            reduce_timer_slack();
+
+        printf("%s\n    {\"name\": \"%s\", \"buckets\": [", strategy ? "," : "",
+            strategy_names[strategy]);
+
+        for (size_t i = 0; i < ndurations; i++) {
+            double d = durations[i];
+            unsigned long n = d > 0 ? (unsigned long)(CALIBRATE_BUDGET / d) : max_samples;
+            if (n > max_samples)
+                n = max_samples;
+            if (n < CALIBRATE_MIN_SAMPLES)
+                n = CALIBRATE_MIN_SAMPLES < max_samples ? CALIBRATE_MIN_SAMPLES : max_samples;
+
+            size_t got = 0;
+            for (unsigned long k = 0; k < n; k++) {
+                double late;
+                if (calibrate_once((enum sleep_strategy)strategy, d, tfd, &late))
+                    samples[got++] = late * 1e6;
+            }
+            qsort(samples, got, sizeof(double), cmp_double);
+
+            printf("%s\n      {\"duration_us\": %.3f, \"samples\": %zu", i ? "," : "", d * 1e6, got);
+            if (got > 0)
+                printf(", \"overshoot_us\": {\"min\": %.3f, \"p50\": %.3f, \"p99\": %.3f, "
+                    "\"p99_9\": %.3f, \"max\": %.3f}",
+                    samples[0], percentile(samples, got, 50), percentile(samples, got, 99),
+                    percentile(samples, got, 99.9), samples[got - 1]);
+            printf("}");
+            fflush(stdout);
+        }
+        printf("\n    ]}");
+    }
+    printf("\n  ]\n}\n");
+
+    free(samples);
+    if (tfd != -1)
+        close(tfd);
+    return EXIT_SUCCESS;
+}
+
 int
 main (int argc, char **argv)
 {
     double seconds = 0;
     bool ok = true;
+    struct delay_options opts = {0};
 
     /* initializing */
     setlocale(LC_ALL, "");
-    parse_cli_args(argc, argv);
+    parse_cli_args(argc, argv, &opts);
+
+    if (opts.has_until && delay_until(&opts.until)) {
+        fprintf(stderr, "%s: cannot read realtime clock.\n", PROGRAM_NAME);
+        return EXIT_FAILURE;
+    }
+
+    if (opts.every)
+        return run_every(argv + optind, &opts);
 
     for (int i = optind; i < argc; i++) {
-        char *endptr;
-        double s = strtod(argv[i], &endptr);
-
-        if (endptr == argv[i] || errno == ERANGE
-            /* nonnegative interval */
-            || !(0 <= s)
-            /* no extra chars after the number and an optional s,m,h,d char. */
-            || (*endptr && *(endptr + 1))
-            /* check any sufix char and update 's' based on sufix. */
-            || !apply_suffix(&s, *endptr))
-        {
+        double s = 0;
+        if (!parse_interval(argv[i], &s)) {
             fprintf(stderr, "%s: invalid time interval '%s'\n", PROGRAM_NAME, argv[i]);
             ok = false;
         }
@@ -151,8 +935,30 @@ main (int argc, char **argv)
     if (!ok)
         usage(EXIT_FAILURE);
 
+    if (opts.is_calibrate) {
+        /* 1us to 1s by default */
+        static const double decades[] = {1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1};
+        size_t n = (size_t)(argc - optind);
+        double *durations = (double *)malloc((n ? n : 1) * sizeof(double));
+        if (durations == NULL) {
+            fprintf(stderr, "%s: memory exhausted\n", PROGRAM_NAME);
+            return EXIT_FAILURE;
+        }
+        for (size_t i = 0; i < n; i++)
+            parse_interval(argv[optind + i], &durations[i]);
+
+        int status = n ? calibrate(durations, n, opts.count ? opts.count : CALIBRATE_SAMPLES)
+            : calibrate(decades, sizeof(decades) / sizeof(decades[0]),
+                opts.count ? opts.count : CALIBRATE_SAMPLES);
+        free(durations);
+        return status;
+    }
+
+    if (opts.has_until)
+        return EXIT_SUCCESS;
+
     /* wait the specified amount of seconds */
-    if (xnanosleep(seconds)) {
+    if (opts.is_progress ? delay_progress(seconds, &opts) : delay_for(seconds, &opts)) {
         fprintf(stderr, "%s: cannot read realtime clock.\n", PROGRAM_NAME);
         return EXIT_FAILURE;
     }
@@ -0,0 +1,163 @@
+/* ewe -- run any of the EWE Coreutils from a single executable
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* gcc ewe.c -o ewe -pthread ./include/xnanosleep.c */
+
+/* The tool to run is picked by the name ewe was invoked as, so a symlink
+   `md -> ewe` behaves like md, or by the first argument: `ewe md`. */
+
+#include "include/tools.c"
+
+/* definitions */
+#define PROGRAM_NAME "ewe"
+#define AUTHOR "netheround"
+
+static int
+mkdir_main (int argc, char **argv)
+{
+    md_name = "mkdir";
+    return md_main(argc, argv);
+}
+
+struct ewe_tool
+{
+    const char *name;
+    int (*main) (int, char **);
+};
+
+static const struct ewe_tool tools[] = {
+    {"md", md_main},
+    {"mkdir", mkdir_main},
+    {"cwd", cwd_main},
+    {"tt", tt_main},
+    {"true", true_main},
+    {"false", false_main},
+    {"delay", delay_main},
+
+    // terminating...
+    {NULL, NULL}
+};
+
+// ...
+
+static const struct ewe_tool *
+find_tool (const char *name)
+{
+    for (const struct ewe_tool *tool = tools; tool->name != NULL; tool++)
+        if (strcmp(tool->name, name) == 0)
+            return tool;
+    return NULL;
+}
+
+static void
+ewe_usage (int status)
+{
+    if (status != EXIT_SUCCESS) {
+        printf("Try '%s --help' for more information.\n", PROGRAM_NAME);
+        exit(status);
+    }
+
+    printf("Usage: %s TOOL [ARGUMENT]...\n"
+    "  or:  TOOL [ARGUMENT]...    (with TOOL a link to %s)\n"
+    "  or:  %s OPTION\n"
+    "Run one of the EWE Coreutils.\n\n", PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME);
+
+    puts("Options:\n"
+    "      --install DIR\tcreate a link named after every tool in DIR\n"
+    "      --help\t\tdisplay this help and exit\n"
+    "      --version\t\toutput version information and exit\n");
+
+    printf("Tools:\n ");
+    for (const struct ewe_tool *tool = tools; tool->name != NULL; tool++)
+        printf(" %s", tool->name);
+    printf("\n");
+    exit(status);
+}
+
+static void
+ewe_version_info()
+{
+    printf("%s (EWE Coreutils) 0.0.1\n"
+    "Copyright (C) 2024\n"
+    "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
+    "This is free software: you are free to change and redistribute it.\n"
+    "\nWritten by %s\n", PROGRAM_NAME, AUTHOR);
+    exit(EXIT_SUCCESS);
+}
+
+/* links every tool name in DIR to this executable. */
+static int
+install_links (const char *dir, const char *argv0)
+{
+    char self[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len == -1) {
+        if (realpath(argv0, self) == NULL) {
+            fprintf(stderr, "%s: cannot locate the executable: %s\n", PROGRAM_NAME, strerror(errno));
+            return EXIT_FAILURE;
+        }
+    } else {
+        self[len] = '\0';
+    }
+
+    int status = EXIT_SUCCESS;
+    for (const struct ewe_tool *tool = tools; tool->name != NULL; tool++) {
+        char link[PATH_MAX];
+        snprintf(link, sizeof(link), "%s/%s", dir, tool->name);
+
+        if (symlink(self, link) == -1) {
+            fprintf(stderr, "%s: cannot create link '%s': %s\n", PROGRAM_NAME, link, strerror(errno));
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
+
+int
+main (int argc, char **argv)
+{
+    const char *name = strrchr(argv[0], '/');
+    name = name ? name + 1 : argv[0];
+
+    /* invoked through a link named after a tool */
+    const struct ewe_tool *tool = find_tool(name);
+    if (tool != NULL)
+        return tool->main(argc, argv);
+
+    if (argc < 2) {
+        printf("%s: missing operand\n", PROGRAM_NAME);
+        ewe_usage(EXIT_FAILURE);
+    }
+
+    if (strcmp(argv[1], "--help") == 0) {
+        ewe_usage(EXIT_SUCCESS);
+    } else if (strcmp(argv[1], "--version") == 0) {
+        ewe_version_info();
+    } else if (strcmp(argv[1], "--install") == 0) {
+        if (argc != 3) {
+            printf("%s: '--install' expects a directory\n", PROGRAM_NAME);
+            ewe_usage(EXIT_FAILURE);
+        }
+        return install_links(argv[2], argv[0]);
+    }
+
+    /* `ewe TOOL ARGUMENTS...`, the tool sees itself as argv[0] */
+    tool = find_tool(argv[1]);
+    if (tool == NULL) {
+        printf("%s: unknown tool '%s'\n", PROGRAM_NAME, argv[1]);
+        ewe_usage(EXIT_FAILURE);
+    }
+    return tool->main(argc - 1, argv + 1);
+}
@@ -63,6 +63,12 @@
 #include "unicodeio.h"
 #include "xprintf.h"
 
+#if defined __AVX2__
+# include <immintrin.h>
+#elif defined __SSE2__
+# include <emmintrin.h>
+#endif
+
 /* The official name of this program (e.g., no 'g' prefix).  */
 #define PROGRAM_NAME "printf"
 
@@ -202,6 +208,67 @@ STRTOX (intmax_t,    vstrtoimax, strtoimax (s, &end, 0))
 STRTOX (uintmax_t,   vstrtoumax, strtoumax (s, &end, 0))
 STRTOX (long double, vstrtold,   cl_strtold (s, &end))
 
+/* Bytes decoded from backslash escapes, and the literal text of the
+   format, not yet written to stdout.  It is flushed before anything else
+   writes to stdout or reports an error, so it never holds output out of
+   order.  */
+static char esc_buf[BUFSIZ];
+static size_t esc_buf_used;
+
+static void
+flush_esc_buf (void)
+{
+  if (esc_buf_used)
+    fwrite (esc_buf, 1, esc_buf_used, stdout);
+  esc_buf_used = 0;
+}
+
+static void
+esc_buf_write (char const *p, size_t n)
+{
+  if (sizeof esc_buf - esc_buf_used < n)
+    {
+      flush_esc_buf ();
+      if (sizeof esc_buf <= n)
+        {
+          fwrite (p, 1, n, stdout);
+          return;
+        }
+    }
+  memcpy (esc_buf + esc_buf_used, p, n);
+  esc_buf_used += n;
+}
+
+static void
+esc_buf_putc (char c)
+{
+  if (esc_buf_used == sizeof esc_buf)
+    flush_esc_buf ();
+  esc_buf[esc_buf_used++] = c;
+}
+
+/* Callbacks for unicode_to_mb, which append the character, or the
+   escape sequence itself if it has no representation in this locale
+   (as print_unicode_char does).  */
+
+static long
+esc_unicode_success (char const *buf, size_t buflen,
+                     MAYBE_UNUSED void *callback_arg)
+{
+  esc_buf_write (buf, buflen);
+  return 0;
+}
+
+static long
+esc_unicode_failure (unsigned int code, MAYBE_UNUSED char const *msg,
+                     MAYBE_UNUSED void *callback_arg)
+{
+  char fallback[sizeof "\\UFFFFFFFF"];
+  int n = sprintf (fallback, code < 0x10000 ? "\\u%04X" : "\\U%08X", code);
+  esc_buf_write (fallback, n);
+  return -1;
+}
+
 /* Output a single-character \ escape.  */
 
 static void
@@ -210,39 +277,40 @@ print_esc_char (char c)
   switch (c)
     {
     case 'a':			/* Alert. */
-      putchar ('\a');
+      esc_buf_putc ('\a');
       break;
     case 'b':			/* Backspace. */
-      putchar ('\b');
+      esc_buf_putc ('\b');
       break;
     case 'c':			/* Cancel the rest of the output. */
+      flush_esc_buf ();
       exit (EXIT_SUCCESS);
       break;
     case 'e':			/* Escape. */
-      putchar ('\x1B');
+      esc_buf_putc ('\x1B');
       break;
     case 'f':			/* Form feed. */
-      putchar ('\f');
+      esc_buf_putc ('\f');
       break;
     case 'n':			/* New line. */
-      putchar ('\n');
+      esc_buf_putc ('\n');
       break;
     case 'r':			/* Carriage return. */
-      putchar ('\r');
+      esc_buf_putc ('\r');
       break;
     case 't':			/* Horizontal tab. */
-      putchar ('\t');
+      esc_buf_putc ('\t');
       break;
     case 'v':			/* Vertical tab. */
-      putchar ('\v');
+      esc_buf_putc ('\v');
       break;
     default:
-      putchar (c);
+      esc_buf_putc (c);
       break;
     }
 }
 
-/* Print a \ escape sequence starting at ESCSTART.
+/* Print a \ escape sequence starting at ESCSTART, into esc_buf.
    Return the number of characters in the escape sequence
    besides the backslash.
    If OCTAL_0 is nonzero, octal escapes are of the form \0ooo, where o
@@ -263,8 +331,11 @@ print_esc (char const *escstart, bool octal_0)
            ++esc_length, ++p)
         esc_value = esc_value * 16 + fromhex (*p);
       if (esc_length == 0)
-        error (EXIT_FAILURE, 0, _("missing hexadecimal number in escape"));
-      putchar (esc_value);
+        {
+          flush_esc_buf ();
+          error (EXIT_FAILURE, 0, _("missing hexadecimal number in escape"));
+        }
+      esc_buf_putc (esc_value);
     }
   else if (isoct (*p))
     {
@@ -275,7 +346,7 @@ print_esc (char const *escstart, bool octal_0)
            esc_length < 3 && isoct (*p);
            ++esc_length, ++p)
         esc_value = esc_value * 8 + fromoct (*p);
-      putchar (esc_value);
+      esc_buf_putc (esc_value);
     }
   else if (*p && strchr ("\"\\abcefnrtv", *p))
     print_esc_char (*p++);
@@ -290,40 +361,64 @@ print_esc (char const *escstart, bool octal_0)
            --esc_length, ++p)
         {
           if (! c_isxdigit (to_uchar (*p)))
-            error (EXIT_FAILURE, 0, _("missing hexadecimal number in escape"));
+            {
+              flush_esc_buf ();
+              error (EXIT_FAILURE, 0,
+                     _("missing hexadecimal number in escape"));
+            }
           uni_value = uni_value * 16 + fromhex (*p);
         }
 
       /* Error for invalid code points 0000D800 through 0000DFFF inclusive.
          Note print_unicode_char() would print the literal \u.. in this case. */
       if (uni_value >= 0xd800 && uni_value <= 0xdfff)
-        error (EXIT_FAILURE, 0, _("invalid universal character name \\%c%0*x"),
-               esc_char, (esc_char == 'u' ? 4 : 8), uni_value);
+        {
+          flush_esc_buf ();
+          error (EXIT_FAILURE, 0,
+                 _("invalid universal character name \\%c%0*x"),
+                 esc_char, (esc_char == 'u' ? 4 : 8), uni_value);
+        }
 
-      print_unicode_char (stdout, uni_value, 0);
+      unicode_to_mb (uni_value, esc_unicode_success, esc_unicode_failure,
+                     nullptr);
     }
   else
     {
-      putchar ('\\');
+      esc_buf_putc ('\\');
       if (*p)
         {
-          putchar (*p);
+          esc_buf_putc (*p);
           p++;
         }
     }
   return p - escstart - 1;
 }
 
-/* Print string STR, evaluating \ escapes. */
+/* Print string STR, evaluating \ escapes.  The text between escapes
+   is copied a run at a time, an argument without any is output as is.  */
 
 static void
 print_esc_string (char const *str)
 {
-  for (; *str; str++)
-    if (*str == '\\')
-      str += print_esc (str, true);
-    else
-      putchar (*str);
+  for (;;)
+    {
+      /* Copy the short runs between escapes as they are walked, and
+         find the end of a longer one with strchr, to copy it at once.  */
+      char const *run = str;
+      while (*str && *str != '\\' && str - run < 16)
+        esc_buf_putc (*str++);
+      if (str - run == 16)
+        {
+          char const *esc = strchr (str, '\\');
+          size_t len = esc ? (size_t) (esc - str) : strlen (str);
+          esc_buf_write (str, len);
+          str += len;
+        }
+      if (!*str)
+        break;
+      str += 1 + print_esc (str, true);
+    }
+  flush_esc_buf ();
 }
 
 /* Evaluate a printf conversion specification.  START is the start of
@@ -477,6 +572,147 @@ print_direc (char const *start, size_t length, char conversion,
   free (p);
 }
 
+/* Return a pointer to the first '%', '\\' or '\0' at or after P.
+   The vector versions only ever load aligned blocks, so like strlen they
+   may read the bytes around the string in the same block, but never past
+   the page holding its terminating null.  */
+
+static char const *
+find_directive (char const *p)
+{
+#if defined __AVX2__
+  uintptr_t misalign = (uintptr_t) p & 31;
+  __m256i const *v = (__m256i const *) (p - misalign);
+  __m256i const percent = _mm256_set1_epi8 ('%');
+  __m256i const backslash = _mm256_set1_epi8 ('\\');
+  __m256i const nul = _mm256_setzero_si256 ();
+  unsigned int mask = -1u << misalign;
+
+  for (;; v++, mask = -1u)
+    {
+      __m256i c = _mm256_load_si256 (v);
+      __m256i hit = _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (c, percent),
+                                                       _mm256_cmpeq_epi8 (c, backslash)),
+                                     _mm256_cmpeq_epi8 (c, nul));
+      unsigned int m = (unsigned int) _mm256_movemask_epi8 (hit) & mask;
+      if (m)
+        return (char const *) v + __builtin_ctz (m);
+    }
+#elif defined __SSE2__
+  uintptr_t misalign = (uintptr_t) p & 15;
+  __m128i const *v = (__m128i const *) (p - misalign);
+  __m128i const percent = _mm_set1_epi8 ('%');
+  __m128i const backslash = _mm_set1_epi8 ('\\');
+  __m128i const nul = _mm_setzero_si128 ();
+  unsigned int mask = -1u << misalign;
+
+  for (;; v++, mask = -1u)
+    {
+      __m128i c = _mm_load_si128 (v);
+      __m128i hit = _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (c, percent),
+                                                _mm_cmpeq_epi8 (c, backslash)),
+                                  _mm_cmpeq_epi8 (c, nul));
+      unsigned int m = (unsigned int) _mm_movemask_epi8 (hit) & mask;
+      if (m)
+        return (char const *) v + __builtin_ctz (m);
+    }
+#else
+  return p + strcspn (p, "%\\");
+#endif
+}
+
+/* The bytes that %q never quotes, wherever they are in the argument,
+   except that '#' and '~' are special at its start and '{' and '}' on
+   their own.  */
+#define SHELL_SAFE_CHARS \
+  "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789" \
+  "#%+,-./:@]_{}~"
+
+/* Return a pointer to the first byte at or after P that is not one of
+   SHELL_SAFE_CHARS, which may be the terminating null.  The vector
+   versions read aligned blocks the way find_directive does, and test for
+   the ranges '+'..':', '@'..'Z' and 'a'..'{' and the bytes
+   '#', '%', ']', '_', '}' and '~'.  */
+
+static char const *
+find_shell_unsafe (char const *p)
+{
+#if defined __AVX2__
+# define SAFE_RANGE(c, lo, hi) \
+  _mm256_and_si256 (_mm256_cmpgt_epi8 (c, _mm256_set1_epi8 ((lo) - 1)), \
+                    _mm256_cmpgt_epi8 (_mm256_set1_epi8 ((hi) + 1), c))
+# define SAFE_BYTE(c, b) _mm256_cmpeq_epi8 (c, _mm256_set1_epi8 (b))
+  uintptr_t misalign = (uintptr_t) p & 31;
+  __m256i const *v = (__m256i const *) (p - misalign);
+  unsigned int mask = -1u << misalign;
+
+  for (;; v++, mask = -1u)
+    {
+      __m256i c = _mm256_load_si256 (v);
+      __m256i safe = _mm256_or_si256 (
+        _mm256_or_si256 (SAFE_RANGE (c, '+', ':'),
+                         _mm256_or_si256 (SAFE_RANGE (c, '@', 'Z'),
+                                          SAFE_RANGE (c, 'a', '{'))),
+        _mm256_or_si256 (
+          _mm256_or_si256 (SAFE_BYTE (c, '#'), SAFE_BYTE (c, '%')),
+          _mm256_or_si256 (_mm256_or_si256 (SAFE_BYTE (c, ']'),
+                                            SAFE_BYTE (c, '_')),
+                           _mm256_or_si256 (SAFE_BYTE (c, '}'),
+                                            SAFE_BYTE (c, '~')))));
+      unsigned int m = ~(unsigned int) _mm256_movemask_epi8 (safe) & mask;
+      if (m)
+        return (char const *) v + __builtin_ctz (m);
+    }
+# undef SAFE_RANGE
+# undef SAFE_BYTE
+#elif defined __SSE2__
+# define SAFE_RANGE(c, lo, hi) \
+  _mm_and_si128 (_mm_cmpgt_epi8 (c, _mm_set1_epi8 ((lo) - 1)), \
+                 _mm_cmplt_epi8 (c, _mm_set1_epi8 ((hi) + 1)))
+# define SAFE_BYTE(c, b) _mm_cmpeq_epi8 (c, _mm_set1_epi8 (b))
+  uintptr_t misalign = (uintptr_t) p & 15;
+  __m128i const *v = (__m128i const *) (p - misalign);
+  unsigned int mask = (0xffffu << misalign) & 0xffffu;
+
+  for (;; v++, mask = 0xffffu)
+    {
+      __m128i c = _mm_load_si128 (v);
+      __m128i safe = _mm_or_si128 (
+        _mm_or_si128 (SAFE_RANGE (c, '+', ':'),
+                      _mm_or_si128 (SAFE_RANGE (c, '@', 'Z'),
+                                    SAFE_RANGE (c, 'a', '{'))),
+        _mm_or_si128 (
+          _mm_or_si128 (SAFE_BYTE (c, '#'), SAFE_BYTE (c, '%')),
+          _mm_or_si128 (_mm_or_si128 (SAFE_BYTE (c, ']'), SAFE_BYTE (c, '_')),
+                        _mm_or_si128 (SAFE_BYTE (c, '}'), SAFE_BYTE (c, '~')))));
+      unsigned int m = ~(unsigned int) _mm_movemask_epi8 (safe) & mask;
+      if (m)
+        return (char const *) v + __builtin_ctz (m);
+    }
+# undef SAFE_RANGE
+# undef SAFE_BYTE
+#else
+  return p + strspn (p, SHELL_SAFE_CHARS);
+#endif
+}
+
+/* Print ARG the way %q does.  An argument the shell would take as it
+   is, which is most of them, is printed verbatim without going through
+   quotearg; only those with special bytes get quoted and escaped.  */
+
+static void
+print_shell_quoted (char const *arg)
+{
+  char const *end = find_shell_unsafe (arg);
+  size_t len = end - arg;
+
+  if (*end == '\0' && len != 0 && *arg != '#' && *arg != '~'
+      && ! (len == 1 && (*arg == '{' || *arg == '}')))
+    fwrite (arg, 1, len, stdout);
+  else
+    fputs (quotearg_style (shell_escape_quoting_style, arg), stdout);
+}
+
 /* Print the text in FORMAT, using ARGV (with ARGC elements) for
    arguments to any '%' directives.
    Return the number of elements of ARGV used.  */
@@ -504,9 +740,11 @@ print_formatted (char const *format, int argc, char **argv)
           have_field_width = have_precision = false;
           if (*f == '%')
             {
-              putchar ('%');
+              esc_buf_putc ('%');
               break;
             }
+          /* The directive writes to stdout itself, or reports an error.  */
+          flush_esc_buf ();
           if (*f == 'b')
             {
               /* FIXME: Field width and precision are not supported
@@ -524,8 +762,7 @@ print_formatted (char const *format, int argc, char **argv)
             {
               if (argc > 0)
                 {
-                  fputs (quotearg_style (shell_escape_quoting_style, *argv),
-                         stdout);
+                  print_shell_quoted (*argv);
                   ++argv;
                   --argc;
                 }
@@ -648,10 +885,27 @@ print_formatted (char const *format, int argc, char **argv)
           break;
 
         default:
-          putchar (*f);
+          {
+            /* Copy the short runs between escapes as they are walked, and
+               find the end of a longer one with a vector scan, to copy it
+               at once.  */
+            char const *run = f;
+            do
+              esc_buf_putc (*f++);
+            while (*f && *f != '%' && *f != '\\' && f - run < 16);
+            if (f - run == 16)
+              {
+                char const *run_end = find_directive (f);
+                esc_buf_write (f, run_end - f);
+                f = run_end;
+              }
+            f--;
+          }
         }
     }
 
+  flush_esc_buf ();
+
   return save_argc - argc;
 }
 
@@ -0,0 +1,383 @@
+/* braceexp.c -- lazily expand shell-like brace patterns
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+/* Supports lists `{in,out,tmp}`, numeric ranges `{0..99}`, `{000..999}`,
+   `{10..0..2}` and character ranges `{a..z}`, in the same order bash
+   generates them (the rightmost brace varies fastest). Like in bash, a brace
+   without a match or a malformed range stays literal text, and expansions
+   that come out empty are dropped. Braces can't be nested, a backslash makes
+   the next character literal. The expansions are produced one at a time
+   from an odometer of indexes, so the memory used depends on the pattern,
+   never on the number of expansions. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+
+enum brace_kind
+{
+    BRACE_LITERAL,
+    BRACE_LIST,
+    BRACE_RANGE
+};
+
+struct brace_segment
+{
+    enum brace_kind kind;
+
+    /* BRACE_LITERAL: the text, BRACE_LIST: the alternatives separated by '\0'. */
+    char *text;
+    size_t len;
+
+    /* BRACE_RANGE, counting from FROM by STEP, down when IS_DOWN. */
+    long from;
+    unsigned long step;
+    bool is_down;
+    int width;
+    bool is_char;
+
+    /* number of values, and the current one. */
+    size_t count;
+    size_t index;
+};
+
+struct brace_pattern
+{
+    struct brace_segment *segments;
+    size_t nsegments;
+
+    /* output buffer, large enough for the longest expansion. */
+    char *buf;
+    size_t size;
+    bool done;
+};
+
+static bool
+brace_parse_long (const char *s, const char *end, long *value, int *width)
+{
+    const char *digits = (*s == '-' || *s == '+') ? s + 1 : s;
+    if (digits == end)
+        return false;
+
+    for (const char *p = digits; p < end; p++)
+        if (!isdigit((unsigned char)*p))
+            return false;
+
+    errno = 0;
+    *value = strtol(s, NULL, 10);
+    if (errno == ERANGE)
+        return false;
+
+    /* zero padded as soon as an end point has a leading zero */
+    *width = (*digits == '0' && end - digits > 1) ? (int)(end - s) : 0;
+    return true;
+}
+
+/* Parses the inside of a brace, BODY of LEN chars, without the braces.
+   Returns -1 when out of memory. */
+static int
+brace_parse_group (struct brace_segment *seg, const char *body, size_t len)
+{
+    const char *dots = NULL;
+    for (size_t i = 0; i + 1 < len; i++) {
+        if (body[i] == '.' && body[i + 1] == '.') {
+            dots = body + i;
+            break;
+        }
+    }
+
+    if (dots != NULL && memchr(body, ',', len) == NULL) {
+        const char *end = body + len;
+        const char *dots2 = NULL;
+        for (const char *p = dots + 2; p + 1 < end; p++) {
+            if (p[0] == '.' && p[1] == '.') {
+                dots2 = p;
+                break;
+            }
+        }
+
+        const char *to_end = dots2 ? dots2 : end;
+        long from, to, step = 1;
+        int wfrom = 0, wto = 0, wstep;
+        bool is_range = true;
+
+        if (dots2 != NULL && !brace_parse_long(dots2 + 2, end, &step, &wstep))
+            is_range = false;
+
+        if (!is_range) {
+            /* a malformed range stays literal, like in bash */
+        } else if (dots - body == 1 && to_end - dots == 3
+            && isalpha((unsigned char)body[0]) && isalpha((unsigned char)dots[2])) {
+            seg->is_char = true;
+            from = (unsigned char)body[0];
+            to = (unsigned char)dots[2];
+        } else if (brace_parse_long(body, dots, &from, &wfrom)
+            && brace_parse_long(dots + 2, to_end, &to, &wto)) {
+            seg->is_char = false;
+        } else {
+            is_range = false;
+        }
+
+        if (is_range) {
+            /* in unsigned arithmetic, the span of two longs doesn't fit one */
+            unsigned long ustep = step < 0 ? 0UL - (unsigned long)step : (unsigned long)step;
+            if (ustep == 0)
+                ustep = 1;
+
+            unsigned long span = from <= to
+                ? (unsigned long)to - (unsigned long)from
+                : (unsigned long)from - (unsigned long)to;
+
+            /* {LONG_MIN..LONG_MAX} has one value more than a size_t counts */
+            if (span / ustep >= SIZE_MAX)
+                return -1;
+
+            seg->kind = BRACE_RANGE;
+            seg->from = from;
+            seg->step = ustep;
+            seg->is_down = from > to;
+            seg->width = wfrom > wto ? wfrom : wto;
+            seg->count = (size_t)(span / ustep) + 1;
+            return 0;
+        }
+    }
+
+    /* a list, a brace without commas stays literal (like in bash). */
+    seg->text = (char *)malloc(len + 1);
+    if (seg->text == NULL)
+        return -1;
+
+    memcpy(seg->text, body, len);
+    seg->text[len] = '\0';
+    seg->len = len;
+
+    if (memchr(body, ',', len) == NULL) {
+        seg->kind = BRACE_LITERAL;
+        return 0;
+    }
+
+    seg->kind = BRACE_LIST;
+    seg->count = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (seg->text[i] == ',') {
+            seg->text[i] = '\0';
+            seg->count++;
+        }
+    }
+    return 0;
+}
+
+/* Writes the current value of SEG to DST, AVAIL bytes with the room for a
+   '\0' (the buffer is sized for the longest value), returns its length. */
+static size_t
+brace_value (struct brace_segment *seg, char *dst, size_t avail)
+{
+    size_t len = 0;
+    switch (seg->kind)
+    {
+        case BRACE_LITERAL:
+            len = seg->len;
+            memcpy(dst, seg->text, len < avail ? len : avail - 1);
+            break;
+
+        case BRACE_LIST: {
+            const char *p = seg->text;
+            for (size_t i = 0; i < seg->index; i++)
+                p += strlen(p) + 1;
+            len = strlen(p);
+            memcpy(dst, p, len < avail ? len : avail - 1);
+            break;
+        }
+
+        case BRACE_RANGE: {
+            unsigned long offset = (unsigned long)seg->index * seg->step;
+            long value = (long)(seg->is_down
+                ? (unsigned long)seg->from - offset
+                : (unsigned long)seg->from + offset);
+
+            if (seg->is_char)
+                len = (size_t)snprintf(dst, avail, "%c", (int)value);
+            else
+                len = (size_t)snprintf(dst, avail, "%0*ld", seg->width, value);
+            break;
+        }
+    }
+    return len < avail ? len : avail - 1;
+}
+
+void
+brace_free (struct brace_pattern *bp)
+{
+    for (size_t i = 0; i < bp->nsegments; i++)
+        free(bp->segments[i].text);
+    free(bp->segments);
+    free(bp->buf);
+    memset(bp, 0, sizeof(*bp));
+}
+
+/* Returns the '}' closing the brace at P, counting the ones nested in it,
+   or NULL when there is none. */
+static const char *
+brace_match (const char *p)
+{
+    size_t depth = 0;
+    for (; *p != '\0'; p++) {
+        if (*p == '\\' && p[1] != '\0')
+            p++;
+        else if (*p == '{')
+            depth++;
+        else if (*p == '}' && --depth == 0)
+            return p;
+    }
+    return NULL;
+}
+
+/* Parses PATTERN into BP, returns -1 if it isn't valid (nested braces, a
+   range too large to count) or on ENOMEM. */
+int
+brace_parse (struct brace_pattern *bp, const char *pattern)
+{
+    size_t len = strlen(pattern);
+    memset(bp, 0, sizeof(*bp));
+
+    /* a pattern never has more segments than characters */
+    bp->segments = (struct brace_segment *)calloc(len + 1, sizeof(*bp->segments));
+    if (bp->segments == NULL)
+        return -1;
+
+    char *literal = (char *)malloc(len + 1);
+    if (literal == NULL) {
+        brace_free(bp);
+        return -1;
+    }
+
+    size_t size = 1;
+    size_t lit_len = 0;
+    const char *p = pattern;
+
+    while (true) {
+        if (*p == '\\' && p[1] != '\0') {
+            literal[lit_len++] = p[1];
+            p += 2;
+            continue;
+        }
+
+        /* without a '}', a '{' is just a character */
+        const char *close = *p == '{' ? brace_match(p) : NULL;
+        if (*p != '\0' && close == NULL) {
+            literal[lit_len++] = *p++;
+            continue;
+        }
+
+        if (lit_len > 0) {
+            struct brace_segment *seg = &bp->segments[bp->nsegments++];
+            seg->kind = BRACE_LITERAL;
+            seg->text = (char *)malloc(lit_len + 1);
+            if (seg->text == NULL)
+                goto fail;
+
+            memcpy(seg->text, literal, lit_len);
+            seg->text[lit_len] = '\0';
+            seg->len = lit_len;
+            size += lit_len;
+            lit_len = 0;
+        }
+
+        if (*p == '\0')
+            break;
+
+        /* *p == '{', nested braces aren't supported */
+        if (memchr(p + 1, '{', close - p - 1) != NULL)
+            goto fail;
+
+        struct brace_segment *seg = &bp->segments[bp->nsegments++];
+        if (brace_parse_group(seg, p + 1, close - p - 1) == -1)
+            goto fail;
+
+        if (seg->kind == BRACE_LITERAL) {
+            /* keep the braces around it */
+            char *text = (char *)malloc(seg->len + 3);
+            if (text == NULL)
+                goto fail;
+
+            text[0] = '{';
+            memcpy(text + 1, seg->text, seg->len);
+            text[seg->len + 1] = '}';
+            text[seg->len + 2] = '\0';
+            free(seg->text);
+            seg->text = text;
+            seg->len += 2;
+        }
+
+        /* ranges print at most a long (or its padding), lists their longest alternative */
+        size += seg->kind == BRACE_RANGE ? (size_t)seg->width + 24 : seg->len;
+        p = close + 1;
+    }
+
+    free(literal);
+    bp->buf = (char *)malloc(size);
+    bp->size = size;
+    if (bp->buf == NULL) {
+        brace_free(bp);
+        return -1;
+    }
+    return 0;
+
+fail:
+    free(literal);
+    brace_free(bp);
+    return -1;
+}
+
+/* advances the odometer of BP, the rightmost brace first. */
+static void
+brace_advance (struct brace_pattern *bp)
+{
+    bp->done = true;
+    for (size_t i = bp->nsegments; i-- > 0;) {
+        struct brace_segment *seg = &bp->segments[i];
+        if (seg->kind == BRACE_LITERAL)
+            continue;
+
+        if (++seg->index < seg->count) {
+            bp->done = false;
+            break;
+        }
+        seg->index = 0;
+    }
+}
+
+/* Returns the next expansion of BP that isn't empty, or NULL once all of
+   them were returned. The string stays valid until the next call. */
+const char *
+brace_next (struct brace_pattern *bp)
+{
+    size_t used = 0;
+    while (used == 0) {
+        if (bp->done)
+            return NULL;
+
+        for (size_t i = 0; i < bp->nsegments; i++)
+            used += brace_value(&bp->segments[i], bp->buf + used, bp->size - used);
+        bp->buf[used] = '\0';
+        brace_advance(bp);
+    }
+    return bp->buf;
+}
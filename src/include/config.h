@@ -1,3 +1,26 @@
 /* TODO: while coding, ive experienced a lot of duplications during the versioning, or getopt cases,
     so it's better to have some nice functions defined in here that we can call them in other programs.
-*/
\ No newline at end of file
+*/
+
+#ifndef EWE_CONFIG_H
+#define EWE_CONFIG_H
+
+#include <getopt.h>
+
+/* Rewinds getopt, which keeps its position in globals, so a tool can parse
+   a new argument list in the same process (like the bash builtins do). */
+static inline void
+reset_getopt (void)
+{
+#ifdef __GLIBC__
+    /* 0 also makes glibc forget the rest of its internal state. */
+    optind = 0;
+#else
+    optind = 1;
+# if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+    optreset = 1;
+# endif
+#endif /* __GLIBC__ */
+}
+
+#endif /* EWE_CONFIG_H */
@@ -0,0 +1,40 @@
+/* c-ctype.h -- character classes of the C locale, whatever the current one is
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef EWE_GNULIB_C_CTYPE_H
+#define EWE_GNULIB_C_CTYPE_H
+
+#include <stdbool.h>
+
+static inline bool
+c_isdigit (int c)
+{
+    return '0' <= c && c <= '9';
+}
+
+static inline bool
+c_isxdigit (int c)
+{
+    return c_isdigit(c) || ('a' <= c && c <= 'f') || ('A' <= c && c <= 'F');
+}
+
+static inline bool
+c_isprint (int c)
+{
+    return ' ' <= c && c <= '~';
+}
+
+#endif /* EWE_GNULIB_C_CTYPE_H */
@@ -0,0 +1,66 @@
+/* cl-strtod.h -- strtod that also accepts the C locale's syntax
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef EWE_GNULIB_CL_STRTOD_H
+#define EWE_GNULIB_CL_STRTOD_H
+
+#include <stdlib.h>
+#include <errno.h>
+#include <locale.h>
+
+/* strtold in the C locale, with the thread's locale swapped for a moment */
+static inline long double
+c_strtold (char const *nptr, char **endptr)
+{
+    static locale_t c_locale;
+    if (c_locale == (locale_t)0)
+        c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+    if (c_locale == (locale_t)0)
+        return strtold(nptr, endptr);
+
+    locale_t old = uselocale(c_locale);
+    long double x = strtold(nptr, endptr);
+    uselocale(old);
+    return x;
+}
+
+/* Parses NPTR in the current locale, and again in the C locale when that
+   doesn't get to the end of it (a "1.5" under a locale whose decimal point
+   is a comma): the longer parse wins. */
+static inline long double
+cl_strtold (char const *nptr, char **endptr)
+{
+    char *end;
+    long double x = strtold(nptr, &end);
+
+    if (*end != '\0') {
+        int saved_errno = errno;
+        char *c_end;
+        long double c = c_strtold(nptr, &c_end);
+        if (end < c_end) {
+            x = c;
+            end = c_end;
+        } else {
+            errno = saved_errno;
+        }
+    }
+
+    if (endptr != NULL)
+        *endptr = end;
+    return x;
+}
+
+#endif /* EWE_GNULIB_CL_STRTOD_H */
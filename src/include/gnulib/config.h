@@ -0,0 +1,52 @@
+/* config.h -- what configure and gnulib would define for the sources in src/gnu
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+/* The headers in this directory stand in for the gnulib and coreutils ones
+   the GNU sources include, just enough of them for those sources to build
+   on their own, without configure and without gnulib:
+
+     cd src && gcc -O2 -I include/gnulib gnu/printf.c -o printf
+
+   Everything is static and header only, like the rest of src/include, as
+   each GNU program is a single translation unit. There is no NLS: the
+   messages are the untranslated ones. */
+
+#ifndef EWE_GNULIB_CONFIG_H
+#define EWE_GNULIB_CONFIG_H
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE 1
+#endif
+
+#define PACKAGE "ewe"
+#define PACKAGE_NAME "EWE Coreutils"
+#define PACKAGE_VERSION "0.0.1"
+#define LOCALEDIR "/usr/share/locale"
+
+/* the C23 null pointer constant, for the compilers that default to C99..C17 */
+#if !defined(__cplusplus) && (!defined(__STDC_VERSION__) || __STDC_VERSION__ < 202311L)
+# define nullptr ((void *) 0)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+# define MAYBE_UNUSED __attribute__ ((__unused__))
+# define ATTRIBUTE_FORMAT(spec) __attribute__ ((__format__ spec))
+#else
+# define MAYBE_UNUSED
+# define ATTRIBUTE_FORMAT(spec)
+#endif
+
+#endif /* EWE_GNULIB_CONFIG_H */
@@ -0,0 +1,57 @@
+/* error.h -- gnulib's error and set_program_name
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef EWE_GNULIB_ERROR_H
+#define EWE_GNULIB_ERROR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+/* argv[0], as run, which is what the messages start with */
+static char const *program_name = "";
+
+static inline void
+set_program_name (char const *argv0)
+{
+    program_name = argv0;
+}
+
+/* prints "PROGRAM: MESSAGE", then ": strerror(ERRNUM)" unless ERRNUM is 0,
+   and exits with STATUS unless it is 0. Whatever was written to stdout so
+   far goes out first, so that the two stay in order. */
+static inline void ATTRIBUTE_FORMAT ((__printf__, 3, 4))
+error (int status, int errnum, char const *format, ...)
+{
+    fflush(stdout);
+    fprintf(stderr, "%s: ", program_name);
+
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+
+    if (errnum != 0)
+        fprintf(stderr, ": %s", strerror(errnum));
+    putc('\n', stderr);
+    fflush(stderr);
+
+    if (status != 0)
+        exit(status);
+}
+
+#endif /* EWE_GNULIB_ERROR_H */
@@ -0,0 +1,46 @@
+/* octhexdigits.h -- values of octal and hexadecimal digits
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef EWE_GNULIB_OCTHEXDIGITS_H
+#define EWE_GNULIB_OCTHEXDIGITS_H
+
+#include <stdbool.h>
+
+static inline bool
+isoct (unsigned char c)
+{
+    return '0' <= c && c <= '7';
+}
+
+/* C must be an octal digit */
+static inline int
+fromoct (unsigned char c)
+{
+    return c - '0';
+}
+
+/* C must be a hexadecimal digit */
+static inline int
+fromhex (unsigned char c)
+{
+    if ('a' <= c && c <= 'f')
+        return c - 'a' + 10;
+    if ('A' <= c && c <= 'F')
+        return c - 'A' + 10;
+    return c - '0';
+}
+
+#endif /* EWE_GNULIB_OCTHEXDIGITS_H */
@@ -0,0 +1,294 @@
+/* quote.h -- quote arguments for messages and for the shell
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+/* The two quoting styles of gnulib's quotearg the GNU sources here use,
+   producing the same bytes it does. */
+
+#ifndef EWE_GNULIB_QUOTE_H
+#define EWE_GNULIB_QUOTE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <wchar.h>
+#include <wctype.h>
+#include <langinfo.h>
+
+#include "xalloc.h"
+
+enum quoting_style
+{
+    /* 'like this' (or with the UTF-8 quotation marks), C escapes inside,
+       for the arguments error messages are about */
+    locale_quoting_style,
+
+    /* as shell input: as is when that is safe, otherwise quoted, with the
+       unprintable characters in $'' */
+    shell_escape_quoting_style
+};
+
+struct quote_buffer
+{
+    char *data;
+    size_t used;
+    size_t size;
+};
+
+static inline void
+quote_add (struct quote_buffer *b, char const *s, size_t len)
+{
+    if (b->used + len + 1 > b->size) {
+        b->size = (b->used + len + 1) * 2;
+        b->data = (char *)xrealloc(b->data, b->size);
+    }
+    memcpy(b->data + b->used, s, len);
+    b->used += len;
+    b->data[b->used] = '\0';
+}
+
+static inline void
+quote_addc (struct quote_buffer *b, char c)
+{
+    quote_add(b, &c, 1);
+}
+
+static inline void
+quote_add_octal (struct quote_buffer *b, unsigned char c)
+{
+    char digits[3] = {(char)('0' + (c >> 6)), (char)('0' + ((c >> 3) & 7)), (char)('0' + (c & 7))};
+    quote_add(b, digits, 3);
+}
+
+/* The length of the printable multibyte character at S, or 0 when S starts
+   with a single byte character or with an invalid or unprintable sequence
+   (whose bytes are then taken one at a time). */
+static inline size_t
+quote_multibyte (char const *s, size_t left)
+{
+    if (MB_CUR_MAX == 1 || (unsigned char)*s < 0x80)
+        return 0;
+
+    mbstate_t state;
+    memset(&state, 0, sizeof(state));
+    wchar_t wc;
+    size_t n = mbrtowc(&wc, s, left, &state);
+    if (n == (size_t)-1 || n == (size_t)-2 || n <= 1 || !iswprint((wint_t)wc))
+        return 0;
+    return n;
+}
+
+static inline bool
+quote_is_utf8 (void)
+{
+    return strcmp(nl_langinfo(CODESET), "UTF-8") == 0;
+}
+
+/* the C escape letter of C, or 0 */
+static inline char
+quote_escape_letter (unsigned char c)
+{
+    switch (c)
+    {
+        case '\a': return 'a';
+        case '\b': return 'b';
+        case '\f': return 'f';
+        case '\n': return 'n';
+        case '\r': return 'r';
+        case '\t': return 't';
+        case '\v': return 'v';
+        default: return 0;
+    }
+}
+
+static inline void
+quote_locale (struct quote_buffer *b, char const *arg)
+{
+    bool is_utf8 = quote_is_utf8();
+    char const *left = is_utf8 ? "\xe2\x80\x98" : "'";
+    char const *right = is_utf8 ? "\xe2\x80\x99" : "'";
+    size_t right_len = strlen(right);
+    size_t len = strlen(arg);
+
+    quote_add(b, left, strlen(left));
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)arg[i];
+        size_t m = quote_multibyte(arg + i, len - i);
+
+        if (strncmp(arg + i, right, right_len) == 0) {
+            quote_addc(b, '\\');
+            quote_add(b, arg + i, right_len);
+            i += right_len - 1;
+        } else if (m != 0) {
+            quote_add(b, arg + i, m);
+            i += m - 1;
+        } else if (c == '\\') {
+            quote_add(b, "\\\\", 2);
+        } else if (quote_escape_letter(c) != 0) {
+            quote_addc(b, '\\');
+            quote_addc(b, quote_escape_letter(c));
+        } else if (c < 0x80 && isprint(c)) {
+            quote_addc(b, (char)c);
+        } else {
+            quote_addc(b, '\\');
+            quote_add_octal(b, c);
+        }
+    }
+    quote_add(b, right, strlen(right));
+}
+
+/* whether the shell could take the byte C at I, in an argument LEN long,
+   for something else than a literal */
+static inline bool
+quote_is_shell_special (unsigned char c, size_t i, size_t len)
+{
+    switch (c)
+    {
+        case '{': case '}':
+            return len == 1;
+        case '#': case '~':
+            return i == 0;
+        case ' ': case '!': case '"': case '$': case '&': case '\'':
+        case '(': case ')': case '*': case ';': case '<': case '=':
+        case '>': case '?': case '[': case '\\': case '^': case '`': case '|':
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Adds ARG in single quotes, IS_DOLLAR_OPEN if it starts inside a $''
+   (the quirk below), and returns whether it ended in one. */
+static inline bool
+quote_shell_quoted (struct quote_buffer *b, char const *arg, bool is_dollar_open,
+    bool *has_quote, bool *is_double_safe)
+{
+    size_t len = strlen(arg);
+
+    quote_addc(b, '\'');
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)arg[i];
+        size_t m = quote_multibyte(arg + i, len - i);
+        char letter = quote_escape_letter(c);
+
+        if (m == 0 && (letter != 0 || c >= 0x80 || !isprint(c))) {
+            if (!is_dollar_open) {
+                quote_add(b, "'$'", 3);
+                is_dollar_open = true;
+            }
+            quote_addc(b, '\\');
+            if (letter != 0)
+                quote_addc(b, letter);
+            else
+                quote_add_octal(b, c);
+            *is_double_safe = false;
+            continue;
+        }
+
+        if (c == '\'') {
+            quote_add(b, "'\\''", 4);
+            is_dollar_open = false;
+            *has_quote = true;
+            continue;
+        }
+
+        if (is_dollar_open) {
+            quote_add(b, "''", 2);
+            is_dollar_open = false;
+        }
+
+        if (m != 0) {
+            quote_add(b, arg + i, m);
+            i += m - 1;
+            continue;
+        }
+
+        quote_addc(b, (char)c);
+        if (c == ' ')
+            continue;
+        if (c == '{' || c == '}' || c == '#' || c == '~')
+            *is_double_safe = *is_double_safe && quote_is_shell_special(c, i, len);
+        else if (quote_is_shell_special(c, i, len))
+            *is_double_safe = false;
+    }
+    quote_addc(b, '\'');
+    return is_dollar_open;
+}
+
+static inline void
+quote_shell (struct quote_buffer *b, char const *arg)
+{
+    size_t len = strlen(arg);
+    size_t i;
+
+    /* as is, when nothing in it needs quoting */
+    for (i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)arg[i];
+        size_t m = quote_multibyte(arg + i, len - i);
+        if (m != 0) {
+            i += m - 1;
+            continue;
+        }
+        if (quote_is_shell_special(c, i, len) || c >= 0x80 || !isprint(c))
+            break;
+    }
+    if (len != 0 && i == len) {
+        quote_add(b, arg, len);
+        return;
+    }
+
+    /* Otherwise in single quotes, where only the quote itself can't be,
+       leaving them for $'' around the unprintable bytes. An apostrophe is
+       common enough to use double quotes instead, when nothing else in the
+       argument would need a backslash there. */
+    bool has_quote = false, is_double_safe = true;
+    bool is_dollar_open = quote_shell_quoted(b, arg, false, &has_quote, &is_double_safe);
+
+    if (has_quote && is_double_safe) {
+        b->used = 0;
+        quote_addc(b, '"');
+        quote_add(b, arg, len);
+        quote_addc(b, '"');
+    } else if (has_quote && is_dollar_open) {
+        /* quotearg goes over an argument with a quote twice, the second
+           time still in the $'' the first one ended in */
+        b->used = 0;
+        quote_shell_quoted(b, arg, true, &has_quote, &is_double_safe);
+    }
+}
+
+/* ARG quoted in STYLE, in storage the next call reuses */
+static inline char const *
+quotearg_style (enum quoting_style style, char const *arg)
+{
+    static struct quote_buffer buffer;
+
+    buffer.used = 0;
+    quote_add(&buffer, "", 0);
+    if (style == shell_escape_quoting_style)
+        quote_shell(&buffer, arg);
+    else
+        quote_locale(&buffer, arg);
+    return buffer.data;
+}
+
+static inline char const *
+quote (char const *arg)
+{
+    return quotearg_style(locale_quoting_style, arg);
+}
+
+#endif /* EWE_GNULIB_QUOTE_H */
@@ -0,0 +1,154 @@
+/* system.h -- what coreutils' system.h gives the GNU sources in src/gnu
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef EWE_GNULIB_SYSTEM_H
+#define EWE_GNULIB_SYSTEM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <locale.h>
+#include <unistd.h>
+#include <wchar.h>
+
+#include "unlocked-io.h"
+#include "error.h"
+#include "xalloc.h"
+
+#define Version PACKAGE_VERSION
+
+/* no NLS */
+#define _(msgid) (msgid)
+#define N_(msgid) msgid
+#define bindtextdomain(domain, dir) ((void) 0)
+#define textdomain(domain) ((void) 0)
+
+#define initialize_main(argcp, argvp) ((void) 0)
+#define proper_name(name) (name)
+
+#define STREQ(a, b) (strcmp(a, b) == 0)
+#define ISDIGIT(c) ((unsigned int)(c) - '0' <= 9)
+
+#ifndef MIN
+# define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+# define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+static inline unsigned char
+to_uchar (char c)
+{
+    return (unsigned char)c;
+}
+
+static inline void
+mbszero (mbstate_t *ps)
+{
+    memset(ps, 0, sizeof(*ps));
+}
+
+#ifndef __GLIBC__
+static inline void *
+mempcpy (void *dest, void const *src, size_t n)
+{
+    return (char *)memcpy(dest, src, n) + n;
+}
+#endif
+
+#define HELP_OPTION_DESCRIPTION \
+    _("      --help        display this help and exit\n")
+#define VERSION_OPTION_DESCRIPTION \
+    _("      --version     output version information and exit\n")
+
+#define USAGE_BUILTIN_WARNING \
+    _("\n" \
+"Your shell may have its own version of %s, which usually supersedes\n" \
+"the version described here.  Please refer to your shell's documentation\n" \
+"for details about the options it supports.\n")
+
+static inline void
+emit_try_help (void)
+{
+    fprintf(stderr, _("Try '%s --help' for more information.\n"), program_name);
+}
+
+static inline void
+emit_ancillary_info (char const *program)
+{
+    printf(_("\nFull documentation <https://www.gnu.org/software/coreutils/%s>\n"), program);
+}
+
+/* The --version output: "PROGRAM (PACKAGE) VERSION", the license and the
+   null terminated list of authors. */
+static inline void
+version_etc (FILE *stream, char const *command_name, char const *package,
+    char const *version, ...)
+{
+    fprintf(stream, "%s (%s) %s\n", command_name, package, version);
+    fputs(_("Copyright (C) 2024 Free Software Foundation, Inc.\n"
+    "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
+    "This is free software: you are free to change and redistribute it.\n"
+    "There is NO WARRANTY, to the extent permitted by law.\n\n"), stream);
+
+    char const *authors[16];
+    size_t n = 0;
+
+    va_list ap;
+    va_start(ap, version);
+    for (char const *a = va_arg(ap, char const *); a != NULL && n < 16; a = va_arg(ap, char const *))
+        authors[n++] = a;
+    va_end(ap);
+
+    fputs(_("Written by "), stream);
+    for (size_t i = 0; i < n; i++)
+        fprintf(stream, "%s%s", i == 0 ? "" : i + 1 == n ? _(" and ") : ", ", authors[i]);
+    fputs(".\n", stream);
+}
+
+/* For atexit: a write error anywhere in stdout, including the last flush,
+   is reported and makes the exit status 1. Closing a stdout that was never
+   open isn't an error, unless something was written to it. */
+static inline void
+close_stdout (void)
+{
+    int err = 0;
+    bool is_failed = false;
+
+    if (fflush(stdout) != 0) {
+        err = errno;
+        is_failed = true;
+    }
+    if (ferror(stdout))
+        is_failed = true;
+    if (fclose(stdout) != 0 && errno != EBADF && !is_failed) {
+        err = errno;
+        is_failed = true;
+    }
+
+    if (is_failed) {
+        error(0, err, "%s", _("write error"));
+        _exit(EXIT_FAILURE);
+    }
+}
+
+#endif /* EWE_GNULIB_SYSTEM_H */
@@ -0,0 +1,122 @@
+/* unicodeio.h -- Unicode characters in the locale's encoding
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef EWE_GNULIB_UNICODEIO_H
+#define EWE_GNULIB_UNICODEIO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <wchar.h>
+#include <langinfo.h>
+
+#include "error.h"
+
+typedef unsigned int ucs4_t;
+
+/* Encodes CODE as UTF-8 into BUF (4 bytes), returns the length or 0 when
+   CODE is a surrogate or past U+10FFFF. */
+static inline int
+u8_uctomb (unsigned char *buf, ucs4_t code)
+{
+    if (code < 0x80) {
+        buf[0] = (unsigned char)code;
+        return 1;
+    }
+    if (code < 0x800) {
+        buf[0] = (unsigned char)(0xC0 | (code >> 6));
+        buf[1] = (unsigned char)(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000) {
+        if (code >= 0xD800 && code < 0xE000)
+            return 0;
+        buf[0] = (unsigned char)(0xE0 | (code >> 12));
+        buf[1] = (unsigned char)(0x80 | ((code >> 6) & 0x3F));
+        buf[2] = (unsigned char)(0x80 | (code & 0x3F));
+        return 3;
+    }
+    if (code < 0x110000) {
+        buf[0] = (unsigned char)(0xF0 | (code >> 18));
+        buf[1] = (unsigned char)(0x80 | ((code >> 12) & 0x3F));
+        buf[2] = (unsigned char)(0x80 | ((code >> 6) & 0x3F));
+        buf[3] = (unsigned char)(0x80 | (code & 0x3F));
+        return 4;
+    }
+    return 0;
+}
+
+/* Converts CODE to the locale's encoding and passes the bytes to SUCCESS,
+   or passes CODE to FAILURE when it has no encoding there, and returns what
+   the callback does. UTF-8 locales are done by hand; anywhere else ASCII is
+   taken as is and the rest goes through wcrtomb, which on the systems
+   defining __STDC_ISO_10646__ takes Unicode code points. */
+static inline long
+unicode_to_mb (ucs4_t code,
+    long (*success) (char const *buf, size_t buflen, void *callback_arg),
+    long (*failure) (ucs4_t code, char const *msg, void *callback_arg),
+    void *callback_arg)
+{
+    unsigned char utf8[4];
+    int len = u8_uctomb(utf8, code);
+    if (len == 0)
+        return failure(code, NULL, callback_arg);
+
+    if (code < 0x80 || strcmp(nl_langinfo(CODESET), "UTF-8") == 0)
+        return success((char const *)utf8, (size_t)len, callback_arg);
+
+#ifdef __STDC_ISO_10646__
+    char buf[MB_LEN_MAX];
+    mbstate_t state;
+    memset(&state, 0, sizeof(state));
+    size_t n = wcrtomb(buf, (wchar_t)code, &state);
+    if (n != (size_t)-1)
+        return success(buf, n, callback_arg);
+#endif
+    return failure(code, NULL, callback_arg);
+}
+
+static inline long
+unicode_fwrite (char const *buf, size_t buflen, void *callback_arg)
+{
+    fwrite(buf, 1, buflen, (FILE *)callback_arg);
+    return 0;
+}
+
+static inline long
+unicode_fallback (ucs4_t code, MAYBE_UNUSED char const *msg, void *callback_arg)
+{
+    fprintf((FILE *)callback_arg, code < 0x10000 ? "\\u%04X" : "\\U%08X", code);
+    return -1;
+}
+
+static inline long
+unicode_fail (ucs4_t code, MAYBE_UNUSED char const *msg, MAYBE_UNUSED void *callback_arg)
+{
+    error(EXIT_FAILURE, 0, "cannot convert U+%04X to local character set", code);
+    return -1;
+}
+
+/* Writes CODE to STREAM in the locale's encoding, or else \uXXXX (or
+   \UXXXXXXXX), or exits when EXIT_ON_ERROR. */
+static inline void
+print_unicode_char (FILE *stream, ucs4_t code, int exit_on_error)
+{
+    unicode_to_mb(code, unicode_fwrite, exit_on_error ? unicode_fail : unicode_fallback, stream);
+}
+
+#endif /* EWE_GNULIB_UNICODEIO_H */
@@ -0,0 +1,48 @@
+/* unlocked-io.h -- stdio without the locking, for single threaded programs
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+/* The GNU programs are single threaded, and coreutils builds them with the
+   stdio calls replaced by their unlocked versions, where the C library has
+   them: a putchar is then a store into the buffer, not a function call
+   taking and releasing the stream's lock. */
+
+#ifndef EWE_GNULIB_UNLOCKED_IO_H
+#define EWE_GNULIB_UNLOCKED_IO_H
+
+#include <stdio.h>
+
+#ifdef __GLIBC__
+# undef clearerr
+# define clearerr(stream) clearerr_unlocked(stream)
+# undef feof
+# define feof(stream) feof_unlocked(stream)
+# undef ferror
+# define ferror(stream) ferror_unlocked(stream)
+# undef fflush
+# define fflush(stream) fflush_unlocked(stream)
+# undef fputc
+# define fputc(c, stream) fputc_unlocked(c, stream)
+# undef fputs
+# define fputs(s, stream) fputs_unlocked(s, stream)
+# undef fwrite
+# define fwrite(p, size, n, stream) fwrite_unlocked(p, size, n, stream)
+# undef putc
+# define putc(c, stream) putc_unlocked(c, stream)
+# undef putchar
+# define putchar(c) putchar_unlocked(c)
+#endif
+
+#endif /* EWE_GNULIB_UNLOCKED_IO_H */
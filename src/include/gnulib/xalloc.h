@@ -0,0 +1,49 @@
+/* xalloc.h -- allocations that can't fail
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef EWE_GNULIB_XALLOC_H
+#define EWE_GNULIB_XALLOC_H
+
+#include <stdlib.h>
+
+#include "error.h"
+
+static inline void
+xalloc_die (void)
+{
+    error(EXIT_FAILURE, 0, "%s", "memory exhausted");
+    abort();
+}
+
+static inline void *
+xmalloc (size_t size)
+{
+    void *p = malloc(size);
+    if (p == NULL && size != 0)
+        xalloc_die();
+    return p;
+}
+
+static inline void *
+xrealloc (void *p, size_t size)
+{
+    p = realloc(p, size);
+    if (p == NULL && size != 0)
+        xalloc_die();
+    return p;
+}
+
+#endif /* EWE_GNULIB_XALLOC_H */
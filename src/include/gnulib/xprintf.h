@@ -0,0 +1,49 @@
+/* xprintf.h -- printf that reports what it can't format
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#ifndef EWE_GNULIB_XPRINTF_H
+#define EWE_GNULIB_XPRINTF_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <errno.h>
+
+#include "error.h"
+
+/* A failure that is not a write error (those are reported by close_stdout)
+   is fatal: it means the format was one printf doesn't support, or the
+   output didn't fit in an int. */
+static inline int ATTRIBUTE_FORMAT ((__printf__, 1, 0))
+xvprintf (char const *format, va_list ap)
+{
+    int ret = vprintf(format, ap);
+    if (ret < 0 && !ferror(stdout))
+        error(EXIT_FAILURE, errno, "%s", "cannot perform formatted output");
+    return ret;
+}
+
+static inline int ATTRIBUTE_FORMAT ((__printf__, 1, 2))
+xprintf (char const *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    int ret = xvprintf(format, ap);
+    va_end(ap);
+    return ret;
+}
+
+#endif /* EWE_GNULIB_XPRINTF_H */
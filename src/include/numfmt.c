@@ -0,0 +1,486 @@
+/* numfmt.c -- printf conversions for integers and floating point, quickly
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+/* Formats %d %i %u %o %x %X (of an intmax_t or uintmax_t) and %f %F %e %E
+   %g %G (of a long double) byte for byte like glibc's printf in the C
+   locale, without its general purpose machinery: integers are written two
+   digits at a time from a table, hex and octal a digit per table lookup.
+
+   Floating point is not printed shortest round-trip, printf prints the
+   exact binary value rounded to the precision. That is done here exactly
+   too, with 128-bit integer arithmetic, as long as the scaled value fits:
+   x87 long doubles, a precision up to 18 and magnitudes up to 2^63 (the
+   ones where %e and %g need no more than a 10^19 scale). Everything else
+   (inf, nan, %a, huge widths, the ' and I flags...) is left to snprintf,
+   each function returns 0 when it can't do the conversion. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+/* what a conversion is written into, the widest one this handles */
+#define NUMFMT_SIZE 128
+
+/* flags */
+#define NUMFMT_LEFT 0x01
+#define NUMFMT_PLUS 0x02
+#define NUMFMT_SPACE 0x04
+#define NUMFMT_ALT 0x08
+#define NUMFMT_ZERO 0x10
+/* ' or I, nothing here knows about those */
+#define NUMFMT_LOCALE 0x20
+
+struct numfmt
+{
+    unsigned flags;
+
+    /* negative for left adjusted */
+    int width;
+
+    /* -1 without one */
+    int precision;
+
+    char conversion;
+};
+
+#if LDBL_MANT_DIG == 64 && defined(__SIZEOF_INT128__)
+# define NUMFMT_HAS_FLOAT 1
+typedef unsigned __int128 numfmt_u128;
+#else
+# define NUMFMT_HAS_FLOAT 0
+#endif
+
+static const char numfmt_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint64_t numfmt_pow10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/* writes N in decimal so that it ends at END, returns the number of digits. */
+static size_t
+numfmt_decimal (uint64_t n, char *end)
+{
+    char *p = end;
+    while (n >= 100) {
+        unsigned r = (unsigned)(n % 100);
+        n /= 100;
+        p -= 2;
+        memcpy(p, numfmt_pairs + 2 * r, 2);
+    }
+    if (n >= 10) {
+        p -= 2;
+        memcpy(p, numfmt_pairs + 2 * n, 2);
+    } else {
+        *--p = (char)('0' + n);
+    }
+    return (size_t)(end - p);
+}
+
+/* the same in base 1 << SHIFT (8 or 16), with DIGITS. */
+static size_t
+numfmt_power2 (uint64_t n, char *end, unsigned shift, const char *digits)
+{
+    char *p = end;
+    uint64_t mask = (1u << shift) - 1;
+    do {
+        *--p = digits[n & mask];
+        n >>= shift;
+    } while (n != 0);
+    return (size_t)(end - p);
+}
+
+/* Lays out PREFIX (the sign, or 0x), ZEROS zeros and the LEN bytes of BODY
+   padded to the width of NF into BUF. Returns the length, 0 if it's too long. */
+static size_t
+numfmt_pad (const struct numfmt *nf, bool can_zero_pad, const char *prefix, size_t prefix_len,
+    size_t zeros, const char *body, size_t len, char *buf)
+{
+    size_t core = prefix_len + zeros + len;
+    bool is_left = nf->width < 0 || (nf->flags & NUMFMT_LEFT);
+    size_t width = nf->width < 0 ? -(size_t)nf->width : (size_t)nf->width;
+    size_t pad = width > core ? width - core : 0;
+
+    if (core + pad > NUMFMT_SIZE)
+        return 0;
+
+    /* '0' pads between the sign and the digits */
+    if (!is_left && can_zero_pad && (nf->flags & NUMFMT_ZERO)) {
+        zeros += pad;
+        pad = 0;
+    }
+
+    char *p = buf;
+    if (!is_left) {
+        memset(p, ' ', pad);
+        p += pad;
+    }
+    memcpy(p, prefix, prefix_len);
+    p += prefix_len;
+    memset(p, '0', zeros);
+    p += zeros;
+    memcpy(p, body, len);
+    p += len;
+    if (is_left) {
+        memset(p, ' ', pad);
+        p += pad;
+    }
+    return (size_t)(p - buf);
+}
+
+/* %d %i (VALUE is an intmax_t then) %u %o %x %X into BUF (NUMFMT_SIZE bytes),
+   returns the length or 0. */
+size_t
+numfmt_integer (const struct numfmt *nf, uintmax_t value, char *buf)
+{
+    char digits[32];
+    char *end = digits + sizeof(digits);
+    char prefix[2];
+    size_t prefix_len = 0;
+    size_t len = 0;
+
+    if ((nf->flags & NUMFMT_LOCALE) || nf->precision > NUMFMT_SIZE || sizeof(uintmax_t) > 8)
+        return 0;
+
+    switch (nf->conversion)
+    {
+        case 'd':
+        case 'i':
+            if ((intmax_t)value < 0) {
+                prefix[prefix_len++] = '-';
+                value = -value;
+            } else if (nf->flags & NUMFMT_PLUS) {
+                prefix[prefix_len++] = '+';
+            } else if (nf->flags & NUMFMT_SPACE) {
+                prefix[prefix_len++] = ' ';
+            }
+            /* fall through */
+        case 'u':
+            if (value != 0 || nf->precision != 0)
+                len = numfmt_decimal(value, end);
+            break;
+
+        case 'o':
+            if (value != 0 || nf->precision != 0)
+                len = numfmt_power2(value, end, 3, "01234567");
+            break;
+
+        case 'x':
+        case 'X':
+            if (value != 0 || nf->precision != 0)
+                len = numfmt_power2(value, end, 4, nf->conversion == 'x'
+                    ? "0123456789abcdef" : "0123456789ABCDEF");
+            if (value != 0 && (nf->flags & NUMFMT_ALT)) {
+                prefix[prefix_len++] = '0';
+                prefix[prefix_len++] = nf->conversion;
+            }
+            break;
+
+        default:
+            return 0;
+    }
+
+    size_t precision = nf->precision < 0 ? 0 : (size_t)nf->precision;
+    size_t zeros = precision > len ? precision - len : 0;
+
+    /* %#o starts with a 0, whatever the precision */
+    if (nf->conversion == 'o' && (nf->flags & NUMFMT_ALT) && zeros == 0
+        && (len == 0 || *(end - len) != '0'))
+        zeros = 1;
+
+    return numfmt_pad(nf, nf->precision < 0, prefix, prefix_len, zeros, end - len, len, buf);
+}
+
+#if NUMFMT_HAS_FLOAT
+
+/* Sets *Q to |X| * 10^P10 rounded to the nearest integer, ties to even,
+   exactly. False if that doesn't fit in 128 bits on the way. */
+static bool
+numfmt_scale (long double x, int p10, numfmt_u128 *q)
+{
+    if (x == 0) {
+        *q = 0;
+        return true;
+    }
+    if (p10 < -19 || p10 > 19)
+        return false;
+
+    /* x = m * 2^e2, with all 64 bits of the mantissa in m */
+    int exp;
+    long double fraction = frexpl(fabsl(x), &exp);
+    uint64_t m = (uint64_t)ldexpl(fraction, 64);
+    int e2 = exp - 64;
+
+    numfmt_u128 n, rem, half;
+    if (p10 >= 0) {
+        n = (numfmt_u128)m * numfmt_pow10[p10];
+        if (e2 >= 0) {
+            if (e2 >= 64 || (n >> (128 - e2)) != 0)
+                return false;
+            *q = n << e2;
+            return true;
+        }
+
+        int k = -e2;
+        if (k >= 128)
+            return false;
+        *q = n >> k;
+        rem = n & (((numfmt_u128)1 << k) - 1);
+        half = (numfmt_u128)1 << (k - 1);
+        if (rem > half || (rem == half && (*q & 1)))
+            (*q)++;
+        return true;
+    }
+
+    uint64_t d = numfmt_pow10[-p10];
+    if (e2 >= 0) {
+        if (e2 > 64)
+            return false;
+        n = (numfmt_u128)m << e2;
+        *q = n / d;
+        rem = n % d;
+        if (rem > d - rem || (rem == d - rem && (*q & 1)))
+            (*q)++;
+        return true;
+    }
+
+    if (-e2 > 64)
+        return false;
+    numfmt_u128 den = (numfmt_u128)d << -e2;
+    *q = m / den;
+    rem = m % den;
+    if (rem > den - rem || (rem == den - rem && (*q & 1)))
+        (*q)++;
+    return true;
+}
+
+/* Rounds |X| to DIGITS significant digits: *Q (DIGITS digits long) and
+   the decimal exponent of the first one in *EXP10. */
+static bool
+numfmt_significant (long double x, int digits, uint64_t *q, int *exp10)
+{
+    if (x == 0) {
+        *q = 0;
+        *exp10 = 0;
+        return true;
+    }
+
+    /* |x| >= 2^(exp - 1), so that's the exponent or the one below it */
+    int exp;
+    frexpl(fabsl(x), &exp);
+    int e10 = ((exp - 1) * 78913) >> 18;
+
+    for (int tries = 0; tries < 3; tries++) {
+        numfmt_u128 scaled;
+        if (!numfmt_scale(x, digits - 1 - e10, &scaled))
+            return false;
+
+        if (scaled >= numfmt_pow10[digits]) {
+            e10++;
+        } else if (scaled < numfmt_pow10[digits - 1]) {
+            e10--;
+        } else {
+            *q = (uint64_t)scaled;
+            *exp10 = e10;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* writes the exponent of %e, e+05 or E-123, returns its length. */
+static size_t
+numfmt_exponent (int exp10, char e, char *p)
+{
+    p[0] = e;
+    p[1] = exp10 < 0 ? '-' : '+';
+    unsigned n = exp10 < 0 ? (unsigned)-exp10 : (unsigned)exp10;
+    if (n < 10) {
+        p[2] = '0';
+        p[3] = (char)('0' + n);
+        return 4;
+    }
+    size_t digits = n < 100 ? 2 : n < 1000 ? 3 : 4;
+    return 2 + numfmt_decimal(n, p + 2 + digits);
+}
+
+#endif /* NUMFMT_HAS_FLOAT */
+
+/* %f %F %e %E %g %G into BUF (NUMFMT_SIZE bytes), returns the length or 0. */
+size_t
+numfmt_float (const struct numfmt *nf, long double x, char *buf)
+{
+#if NUMFMT_HAS_FLOAT
+    char body[64];
+    size_t len = 0;
+    char prefix[1];
+    size_t prefix_len = 0;
+    bool is_alt = nf->flags & NUMFMT_ALT;
+    int precision = nf->precision < 0 ? 6 : nf->precision;
+
+    if ((nf->flags & NUMFMT_LOCALE) || isnan(x) || isinf(x))
+        return 0;
+
+    if (signbit(x))
+        prefix[prefix_len++] = '-';
+    else if (nf->flags & NUMFMT_PLUS)
+        prefix[prefix_len++] = '+';
+    else if (nf->flags & NUMFMT_SPACE)
+        prefix[prefix_len++] = ' ';
+
+    switch (nf->conversion)
+    {
+        case 'f':
+        case 'F': {
+            numfmt_u128 q;
+            if (precision > 19 || fabsl(x) >= 0x1p63L || !numfmt_scale(x, precision, &q))
+                return 0;
+
+            uint64_t p10 = numfmt_pow10[precision];
+            uint64_t int_part = (uint64_t)(q / p10);
+            uint64_t frac = (uint64_t)(q % p10);
+
+            char tmp[24];
+            size_t n = numfmt_decimal(int_part, tmp + sizeof(tmp));
+            memcpy(body, tmp + sizeof(tmp) - n, n);
+            len = n;
+
+            if (precision > 0 || is_alt)
+                body[len++] = '.';
+            if (precision > 0) {
+                memset(body + len, '0', (size_t)precision);
+                numfmt_decimal(frac, body + len + precision);
+                len += (size_t)precision;
+            }
+            break;
+        }
+
+        case 'e':
+        case 'E': {
+            uint64_t q;
+            int exp10;
+            if (precision > 18 || !numfmt_significant(x, precision + 1, &q, &exp10))
+                return 0;
+
+            char digits[24];
+            numfmt_decimal(q, digits + precision + 1);
+            if (q == 0)
+                memset(digits, '0', (size_t)precision + 1);
+
+            body[len++] = digits[0];
+            if (precision > 0 || is_alt)
+                body[len++] = '.';
+            memcpy(body + len, digits + 1, (size_t)precision);
+            len += (size_t)precision;
+            len += numfmt_exponent(exp10, nf->conversion, body + len);
+            break;
+        }
+
+        case 'g':
+        case 'G': {
+            uint64_t q;
+            int exp10;
+            int p = precision == 0 ? 1 : precision;
+            if (p > 18 || !numfmt_significant(x, p, &q, &exp10))
+                return 0;
+
+            char digits[24];
+            numfmt_decimal(q, digits + p);
+            if (q == 0)
+                memset(digits, '0', (size_t)p);
+
+            /* the fraction digits kept, trailing zeros go without '#' */
+            size_t keep;
+            if (exp10 < p && exp10 >= -4) {
+                /* %f with precision p - 1 - exp10 */
+                const char *frac;
+                size_t frac_len;
+                if (exp10 >= 0) {
+                    memcpy(body, digits, (size_t)exp10 + 1);
+                    len = (size_t)exp10 + 1;
+                    frac = digits + exp10 + 1;
+                    frac_len = (size_t)(p - 1 - exp10);
+                } else {
+                    body[len++] = '0';
+                    frac = digits;
+                    frac_len = (size_t)p;
+                }
+
+                keep = frac_len;
+                if (!is_alt)
+                    while (keep > 0 && frac[keep - 1] == '0')
+                        keep--;
+
+                if (keep > 0 || is_alt) {
+                    body[len++] = '.';
+                    if (exp10 < 0) {
+                        memset(body + len, '0', (size_t)(-exp10 - 1));
+                        len += (size_t)(-exp10 - 1);
+                    }
+                }
+                memcpy(body + len, frac, keep);
+                len += keep;
+            } else {
+                keep = (size_t)p - 1;
+
+                /* glibc picks the number of digits before rounding: when
+                   rounding up carries 999999.5 over into %e, %#g still
+                   prints as many decimals as %f would have, none. */
+                if (exp10 == p && q == numfmt_pow10[p - 1]
+                    && fabsl(x) < (long double)numfmt_pow10[p])
+                    keep = 0;
+
+                if (!is_alt)
+                    while (keep > 0 && digits[keep] == '0')
+                        keep--;
+
+                body[len++] = digits[0];
+                if (keep > 0 || is_alt)
+                    body[len++] = '.';
+                memcpy(body + len, digits + 1, keep);
+                len += keep;
+                len += numfmt_exponent(exp10, nf->conversion == 'g' ? 'e' : 'E', body + len);
+            }
+            break;
+        }
+
+        default:
+            return 0;
+    }
+
+    return numfmt_pad(nf, true, prefix, prefix_len, 0, body, len, buf);
+#else
+    (void)nf;
+    (void)x;
+    (void)buf;
+    return 0;
+#endif /* NUMFMT_HAS_FLOAT */
+}
@@ -0,0 +1,481 @@
+/* tiny.c -- a freestanding runtime for the startup-minimal builds
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+/* Used by the tools in tiny/, built with:
+
+     gcc -Os -static -nostdlib -fno-stack-protector -fno-asynchronous-unwind-tables
+
+   There is no libc at all: _start calls main directly, the few system calls
+   needed are made by hand and nothing is buffered, so a process costs an
+   execve, a handful of pages and an exit_group. Linux on x86_64 and aarch64
+   only, everywhere else use the regular builds. */
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdbool.h>
+
+#if !defined(__linux__) || !(defined(__x86_64__) || defined(__aarch64__))
+# error "the tiny runtime supports x86_64 and aarch64 Linux only"
+#endif
+
+#define EXIT_SUCCESS 0
+#define EXIT_FAILURE 1
+
+#define STDIN_FILENO 0
+#define STDOUT_FILENO 1
+#define STDERR_FILENO 2
+
+#define AT_FDCWD -100
+#define AT_EMPTY_PATH 0x1000
+#define TCGETS 0x5401
+
+#define PATH_MAX 4096
+#define TINY_BUFSIZ 4096
+
+#if defined(__x86_64__)
+# define SYS_write 1
+# define SYS_close 3
+# define SYS_ioctl 16
+# define SYS_getcwd 79
+# define SYS_getdents64 217
+# define SYS_exit_group 231
+# define SYS_openat 257
+# define SYS_newfstatat 262
+# define SYS_readlinkat 267
+# define O_DIRECTORY 0200000
+#else
+# define SYS_getcwd 17
+# define SYS_ioctl 29
+# define SYS_openat 56
+# define SYS_close 57
+# define SYS_getdents64 61
+# define SYS_write 64
+# define SYS_readlinkat 78
+# define SYS_newfstatat 79
+# define SYS_exit_group 94
+# define O_DIRECTORY 040000
+#endif
+
+#define O_RDONLY 0
+#define O_CLOEXEC 02000000
+
+/* st_dev and st_ino lead struct stat on both architectures, the rest is
+   never looked at (and is at most 144 bytes). */
+struct tiny_stat
+{
+    unsigned long dev;
+    unsigned long ino;
+    unsigned long rest[32];
+};
+
+/* a directory entry, as getdents64 returns them one after the other. */
+struct tiny_dirent
+{
+    unsigned long ino;
+    long off;
+    unsigned short reclen;
+    unsigned char type;
+    char name[];
+};
+
+/* not every tool uses every helper */
+#define TINY_FN static __attribute__((unused))
+
+/* the environment, set up by _start. */
+static char **tiny_environ;
+
+/* errno of the last failed tiny_* call. */
+static int tiny_errno;
+
+int main (int argc, char **argv);
+
+static long
+tiny_syscall (long n, long a, long b, long c, long d)
+{
+    long ret;
+#if defined(__x86_64__)
+    register long r10 __asm__("r10") = d;
+    __asm__ volatile ("syscall"
+        : "=a"(ret)
+        : "a"(n), "D"(a), "S"(b), "d"(c), "r"(r10)
+        : "rcx", "r11", "memory");
+#else
+    register long x8 __asm__("x8") = n;
+    register long x0 __asm__("x0") = a;
+    register long x1 __asm__("x1") = b;
+    register long x2 __asm__("x2") = c;
+    register long x3 __asm__("x3") = d;
+    __asm__ volatile ("svc 0"
+        : "+r"(x0)
+        : "r"(x8), "r"(x1), "r"(x2), "r"(x3)
+        : "memory");
+    ret = x0;
+#endif
+
+    /* the kernel returns -errno */
+    if (ret < 0 && ret > -4096) {
+        tiny_errno = (int)-ret;
+        return -1;
+    }
+    return ret;
+}
+
+__attribute__((noreturn)) static void
+tiny_exit (int status)
+{
+    for (;;)
+        tiny_syscall(SYS_exit_group, status, 0, 0, 0);
+}
+
+/* called by _start with the initial stack: argc, argv..., NULL, envp..., NULL. */
+__attribute__((used, noreturn)) static void
+tiny_start (long *sp)
+{
+    int argc = (int)sp[0];
+    char **argv = (char **)(sp + 1);
+
+    tiny_environ = argv + argc + 1;
+    tiny_exit(main(argc, argv));
+}
+
+#if defined(__x86_64__)
+__asm__ (
+    ".text\n"
+    ".global _start\n"
+    "_start:\n"
+    "    xor %rbp, %rbp\n"
+    "    mov %rsp, %rdi\n"
+    "    and $-16, %rsp\n"
+    "    call tiny_start\n"
+    "    hlt\n");
+#else
+__asm__ (
+    ".text\n"
+    ".global _start\n"
+    "_start:\n"
+    "    mov x29, #0\n"
+    "    mov x30, #0\n"
+    "    mov x0, sp\n"
+    "    bl tiny_start\n"
+    "    brk #0\n");
+#endif
+
+/* gcc may emit calls to these even without a libc. */
+
+void *
+memcpy (void *dest, const void *src, size_t n)
+{
+    unsigned char *d = (unsigned char *)dest;
+    const unsigned char *s = (const unsigned char *)src;
+    while (n--)
+        *d++ = *s++;
+    return dest;
+}
+
+void *
+memset (void *dest, int c, size_t n)
+{
+    unsigned char *d = (unsigned char *)dest;
+    while (n--)
+        *d++ = (unsigned char)c;
+    return dest;
+}
+
+size_t
+strlen (const char *s)
+{
+    const char *p = s;
+    while (*p)
+        p++;
+    return (size_t)(p - s);
+}
+
+TINY_FN int
+tiny_strcmp (const char *a, const char *b)
+{
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return (unsigned char)*a - (unsigned char)*b;
+}
+
+/* writes N in decimal to BUF (at least 20 bytes), returns the length. */
+TINY_FN size_t
+tiny_utoa (unsigned long n, char *buf)
+{
+    char tmp[20];
+    size_t len = 0;
+    do {
+        tmp[len++] = (char)('0' + n % 10);
+        n /= 10;
+    } while (n != 0);
+
+    for (size_t i = 0; i < len; i++)
+        buf[i] = tmp[len - 1 - i];
+    return len;
+}
+
+/* writes all of BUF, returns false on a write error. */
+TINY_FN bool
+tiny_write (int fd, const void *buf, size_t len)
+{
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        long n = tiny_syscall(SYS_write, fd, (long)p, (long)len, 0);
+        if (n == -1)
+            return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/* writes the NULL terminated list of strings with a single write(2). */
+TINY_FN bool
+tiny_print (int fd, const char *s, ...)
+{
+    char buf[TINY_BUFSIZ];
+    size_t used = 0;
+    bool ok = true;
+
+    va_list ap;
+    va_start(ap, s);
+    for (; s != NULL; s = va_arg(ap, const char *)) {
+        size_t len = strlen(s);
+        if (used + len > sizeof(buf)) {
+            ok = tiny_write(fd, buf, used) && ok;
+            used = 0;
+        }
+        if (len > sizeof(buf)) {
+            ok = tiny_write(fd, s, len) && ok;
+            continue;
+        }
+        memcpy(buf + used, s, len);
+        used += len;
+    }
+    va_end(ap);
+
+    return tiny_write(fd, buf, used) && ok;
+}
+
+TINY_FN char *
+tiny_getenv (const char *name)
+{
+    size_t len = strlen(name);
+    for (char **env = tiny_environ; *env != NULL; env++) {
+        const char *e = *env;
+        size_t i = 0;
+        while (i < len && e[i] == name[i])
+            i++;
+        if (i == len && e[len] == '=')
+            return (char *)e + len + 1;
+    }
+    return NULL;
+}
+
+TINY_FN char *
+tiny_getcwd (char *buf, size_t size)
+{
+    return tiny_syscall(SYS_getcwd, (long)buf, (long)size, 0, 0) == -1 ? NULL : buf;
+}
+
+TINY_FN bool
+tiny_isatty (int fd)
+{
+    /* struct termios, at most 60 bytes */
+    unsigned long termios[8];
+    return tiny_syscall(SYS_ioctl, fd, TCGETS, (long)termios, 0) == 0;
+}
+
+TINY_FN long
+tiny_readlink (const char *path, char *buf, size_t size)
+{
+    return tiny_syscall(SYS_readlinkat, AT_FDCWD, (long)path, (long)buf, (long)size);
+}
+
+TINY_FN bool
+tiny_stat (const char *path, struct tiny_stat *st)
+{
+    return tiny_syscall(SYS_newfstatat, AT_FDCWD, (long)path, (long)st, 0) == 0;
+}
+
+TINY_FN bool
+tiny_fstat (int fd, struct tiny_stat *st)
+{
+    return tiny_syscall(SYS_newfstatat, fd, (long)"", (long)st, AT_EMPTY_PATH) == 0;
+}
+
+/* returns a fd of the directory PATH, -1 on failure. */
+TINY_FN int
+tiny_opendir (const char *path)
+{
+    return (int)tiny_syscall(SYS_openat, AT_FDCWD, (long)path, O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0);
+}
+
+/* fills BUF with the next entries of the directory FD, see tiny_dirent.
+   Returns the bytes filled, 0 at the end, -1 on failure. */
+TINY_FN long
+tiny_getdents (int fd, void *buf, size_t size)
+{
+    return tiny_syscall(SYS_getdents64, fd, (long)buf, (long)size, 0);
+}
+
+TINY_FN void
+tiny_close (int fd)
+{
+    tiny_syscall(SYS_close, fd, 0, 0, 0);
+}
+
+/* the messages for the errors tiny_getcwd and friends can run into. */
+TINY_FN const char *
+tiny_strerror (int err)
+{
+    switch (err)
+    {
+        case 1: return "Operation not permitted";
+        case 2: return "No such file or directory";
+        case 12: return "Cannot allocate memory";
+        case 13: return "Permission denied";
+        case 14: return "Bad address";
+        case 34: return "Numerical result out of range";
+        case 36: return "File name too long";
+        default: return "Unknown error";
+    }
+}
+
+/* options */
+
+struct tiny_option
+{
+    const char *name;
+    bool has_arg;
+    int val;
+};
+
+struct tiny_getopt
+{
+    int index;
+
+    /* the argument of the last long option that takes one */
+    const char *arg;
+
+    /* position inside a cluster of short options, like -LP */
+    const char *next;
+
+    /* index of the first operand, 0 if there is none */
+    int operand;
+};
+
+/* A getopt_long for short options without arguments and long options with
+   or without one (`--fd 1`, `--fd=1`), printing the same messages glibc
+   does. Operands are skipped over (and the first one remembered) rather
+   than permuted. Returns the option, '?' on error or -1. */
+TINY_FN int
+tiny_getopt (struct tiny_getopt *st, int argc, char **argv,
+    const char *shortopts, const struct tiny_option *longopts)
+{
+    if (st->index == 0)
+        st->index = 1;
+
+    if (st->next == NULL || *st->next == '\0') {
+        st->next = NULL;
+
+        while (st->index < argc) {
+            const char *arg = argv[st->index];
+            if (arg[0] == '-' && arg[1] != '\0')
+                break;
+            if (st->operand == 0)
+                st->operand = st->index;
+            st->index++;
+        }
+
+        if (st->index >= argc)
+            return -1;
+
+        const char *arg = argv[st->index++];
+        if (tiny_strcmp(arg, "--") == 0) {
+            if (st->operand == 0 && st->index < argc)
+                st->operand = st->index;
+            st->index = argc;
+            return -1;
+        }
+
+        if (arg[1] == '-') {
+            const char *name = arg + 2;
+            size_t len = 0;
+            while (name[len] != '\0' && name[len] != '=')
+                len++;
+
+            const struct tiny_option *found = NULL;
+            bool ambiguous = false;
+            for (const struct tiny_option *o = longopts; o->name != NULL; o++) {
+                size_t i = 0;
+                while (i < len && o->name[i] == name[i])
+                    i++;
+                if (i < len)
+                    continue;
+
+                /* an exact match always wins */
+                if (o->name[len] == '\0') {
+                    found = o;
+                    ambiguous = false;
+                    break;
+                }
+                if (found != NULL && found->val != o->val)
+                    ambiguous = true;
+                found = o;
+            }
+
+            if (found == NULL) {
+                tiny_print(STDERR_FILENO, argv[0], ": unrecognized option '", arg, "'\n", NULL);
+                return '?';
+            }
+            if (ambiguous) {
+                tiny_print(STDERR_FILENO, argv[0], ": option '", arg, "' is ambiguous\n", NULL);
+                return '?';
+            }
+            if (!found->has_arg && name[len] == '=') {
+                tiny_print(STDERR_FILENO, argv[0], ": option '--", found->name,
+                    "' doesn't allow an argument\n", NULL);
+                return '?';
+            }
+            if (found->has_arg) {
+                if (name[len] == '=') {
+                    st->arg = name + len + 1;
+                } else if (st->index < argc) {
+                    st->arg = argv[st->index++];
+                } else {
+                    tiny_print(STDERR_FILENO, argv[0], ": option '--", found->name,
+                        "' requires an argument\n", NULL);
+                    return '?';
+                }
+            }
+            return found->val;
+        }
+
+        st->next = arg + 1;
+    }
+
+    char c = *st->next++;
+    for (const char *s = shortopts; *s != '\0'; s++)
+        if (*s == c)
+            return c;
+
+    char opt[2] = {c, '\0'};
+    tiny_print(STDERR_FILENO, argv[0], ": invalid option -- '", opt, "'\n", NULL);
+    return '?';
+}
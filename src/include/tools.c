@@ -0,0 +1,113 @@
+/* tools.c -- every tool of the EWE Coreutils in a single translation unit
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+/* Every tool is #included here, the same way mkdir.c and false.c reuse md.c
+   and true.c, with the names they all share (main, usage, ...) renamed per
+   tool. What's left is one `<tool>_main` and, for the tools that never call
+   exit, one `<tool>_run` per tool; used by ewe.c and builtins.c. */
+
+/* md and mkdir share a single copy, the name is set when dispatching. */
+static const char *md_name = "md";
+
+#define PROGRAM_NAME md_name
+#define main md_main
+#define usage md_usage
+#define version_info md_version_info
+#define long_options md_long_options
+#define HELP_OPTION MD_HELP_OPTION
+#define VERSION_OPTION MD_VERSION_OPTION
+#include "../md.c"
+#undef PROGRAM_NAME
+#undef AUTHOR
+#undef main
+#undef usage
+#undef version_info
+#undef long_options
+#undef HELP_OPTION
+#undef VERSION_OPTION
+
+#define main cwd_main
+#define usage cwd_usage
+#define version_info cwd_version_info
+#define long_options cwd_long_options
+#define HELP_OPTION CWD_HELP_OPTION
+#define VERSION_OPTION CWD_VERSION_OPTION
+#include "../cwd.c"
+#undef PROGRAM_NAME
+#undef AUTHOR
+#undef main
+#undef usage
+#undef version_info
+#undef long_options
+#undef HELP_OPTION
+#undef VERSION_OPTION
+
+#define main tt_main
+#define usage tt_usage
+#define version_info tt_version_info
+#define long_options tt_long_options
+#define HELP_OPTION TT_HELP_OPTION
+#define VERSION_OPTION TT_VERSION_OPTION
+#include "../tt.c"
+#undef PROGRAM_NAME
+#undef AUTHOR
+#undef main
+#undef usage
+#undef version_info
+#undef long_options
+#undef HELP_OPTION
+#undef VERSION_OPTION
+
+#define main true_main
+#define usage true_usage
+#define version_info true_version_info
+#include "../true.c"
+#undef EXIT_STATUS
+#undef PROGRAM_NAME
+#undef AUTHOR
+#undef main
+#undef usage
+#undef version_info
+
+#define EXIT_STATUS EXIT_FAILURE
+#define main false_main
+#define true_run false_run
+#define usage false_usage
+#define version_info false_version_info
+#include "../true.c"
+#undef EXIT_STATUS
+#undef PROGRAM_NAME
+#undef AUTHOR
+#undef main
+#undef true_run
+#undef usage
+#undef version_info
+
+#define main delay_main
+#define usage delay_usage
+#define version_info delay_version_info
+#define long_options delay_long_options
+#define HELP_OPTION DELAY_HELP_OPTION
+#define VERSION_OPTION DELAY_VERSION_OPTION
+#include "../delay.c"
+#undef PROGRAM_NAME
+#undef AUTHOR
+#undef main
+#undef usage
+#undef version_info
+#undef long_options
+#undef HELP_OPTION
+#undef VERSION_OPTION
@@ -0,0 +1,164 @@
+/* workpool.c -- run a range of independent tasks on a work-stealing thread pool
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+/* Every worker starts with an equal slice of the task indexes and takes them
+   from the front of its slice; once it runs dry it steals the upper half of
+   another worker's slice. Link with `-pthread`. */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef void (*workpool_fn) (void *ctx, size_t index);
+
+struct workpool_slice
+{
+    pthread_mutex_t lock;
+    size_t begin;
+    size_t end;
+};
+
+struct workpool_worker
+{
+    struct workpool_slice *slices;
+    size_t nworkers;
+    size_t self;
+    workpool_fn fn;
+    void *ctx;
+};
+
+/* takes the next index of SLICE, false if it is empty. */
+static bool
+workpool_take (struct workpool_slice *slice, size_t *index)
+{
+    bool ok = false;
+
+    pthread_mutex_lock(&slice->lock);
+    if (slice->begin < slice->end) {
+        *index = slice->begin++;
+        ok = true;
+    }
+    pthread_mutex_unlock(&slice->lock);
+    return ok;
+}
+
+/* moves the upper half of some other worker's slice into our own. */
+static bool
+workpool_steal (struct workpool_worker *w)
+{
+    for (size_t i = 1; i < w->nworkers; i++) {
+        struct workpool_slice *victim = &w->slices[(w->self + i) % w->nworkers];
+        size_t begin = 0, end = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        if (victim->begin < victim->end) {
+            begin = victim->begin + (victim->end - victim->begin) / 2;
+            end = victim->end;
+            victim->end = begin;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (begin < end) {
+            struct workpool_slice *own = &w->slices[w->self];
+
+            pthread_mutex_lock(&own->lock);
+            own->begin = begin;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *
+workpool_loop (void *arg)
+{
+    struct workpool_worker *w = (struct workpool_worker *)arg;
+    size_t index;
+
+    do {
+        while (workpool_take(&w->slices[w->self], &index))
+            w->fn(w->ctx, index);
+    } while (workpool_steal(w));
+
+    return NULL;
+}
+
+/* Calls FN(CTX, i) for every i in [0, NTASKS) using up to NTHREADS threads,
+   the calling thread included, and returns once every task has run. Without
+   memory for the pool, the tasks simply run on the calling thread. */
+void
+workpool_run (size_t nthreads, size_t ntasks, workpool_fn fn, void *ctx)
+{
+    if (nthreads > ntasks)
+        nthreads = ntasks;
+
+    struct workpool_slice *slices = NULL;
+    struct workpool_worker *workers = NULL;
+    pthread_t *threads = NULL;
+    bool *started = NULL;
+
+    if (nthreads > 1) {
+        slices = (struct workpool_slice *)calloc(nthreads, sizeof(*slices));
+        workers = (struct workpool_worker *)calloc(nthreads, sizeof(*workers));
+        threads = (pthread_t *)calloc(nthreads, sizeof(*threads));
+        started = (bool *)calloc(nthreads, sizeof(*started));
+    }
+
+    if (slices == NULL || workers == NULL || threads == NULL || started == NULL) {
+        free(slices);
+        free(workers);
+        free(threads);
+        free(started);
+
+        for (size_t i = 0; i < ntasks; i++)
+            fn(ctx, i);
+        return;
+    }
+
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_mutex_init(&slices[i].lock, NULL);
+        slices[i].begin = ntasks * i / nthreads;
+        slices[i].end = ntasks * (i + 1) / nthreads;
+
+        workers[i].slices = slices;
+        workers[i].nworkers = nthreads;
+        workers[i].self = i;
+        workers[i].fn = fn;
+        workers[i].ctx = ctx;
+    }
+
+    /* the calling thread is worker 0, a thread that fails to start just
+       leaves its slice to be stolen by the others. */
+    for (size_t i = 1; i < nthreads; i++)
+        started[i] = pthread_create(&threads[i], NULL, workpool_loop, &workers[i]) == 0;
+
+    workpool_loop(&workers[0]);
+
+    for (size_t i = 1; i < nthreads; i++)
+        if (started[i])
+            pthread_join(threads[i], NULL);
+
+    for (size_t i = 0; i < nthreads; i++)
+        pthread_mutex_destroy(&slices[i].lock);
+
+    free(started);
+    free(slices);
+    free(workers);
+    free(threads);
+}
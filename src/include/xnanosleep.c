@@ -21,18 +21,129 @@
 #include "xnanosleep.h"
 
 #include <errno.h>
+#include <limits.h>
 #include <time.h>
 #include <unistd.h>
 
-/* Sleep until the time (call it WAKE_UP_TIME) specified as
-   SECONDS seconds after the time this function is called.
-   SECONDS must be non-negative.  If SECONDS is so large that
-   it is not representable as a 'struct timespec', then use
-   the maximum value for that interval.  Return -1 on failure
-   (setting errno), 0 on success.  */
+#ifndef TYPE_MAXIMUM
+# define TYPE_MAXIMUM(t) \
+    ((t) ((((t) 1 << (sizeof (t) * CHAR_BIT - 2)) - 1) * 2 + 1))
+#endif
+
+/* Seconds from A to B, negative if B is before A.  */
+
+double
+xtimespec_diff (struct timespec const *a, struct timespec const *b)
+{
+  return (double) (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+/* Add SECONDS (non-negative) to *TS, saturating at the largest
+   representable time.  */
+
+void
+xtimespec_add (struct timespec *ts, double seconds)
+{
+  time_t max = TYPE_MAXIMUM (time_t);
+  if (max - ts->tv_sec <= seconds)
+    {
+      ts->tv_sec = max;
+      ts->tv_nsec = 999999999;
+      return;
+    }
+
+  time_t whole = (time_t) seconds;
+  long nsec = ts->tv_nsec + (long) ((seconds - whole) * 1e9);
+  ts->tv_sec += whole;
+  if (nsec >= 1000000000)
+    {
+      nsec -= 1000000000;
+      if (ts->tv_sec == max)
+        nsec = 999999999;
+      else
+        ts->tv_sec++;
+    }
+  ts->tv_nsec = nsec;
+}
+
+/* Sleep until DEADLINE, an absolute time on CLOCK.  The last SPIN
+   seconds before it are busy-waited instead of slept, to wake up
+   closer to it than the timer slack and the scheduler allow.
+
+   CLOCK is read again after every wake-up, so neither a signal (EINTR)
+   nor a step of CLOCK_REALTIME adds any error: the sleep always ends at
+   DEADLINE as the clock sees it then.  Return -1 on failure (setting
+   errno), 0 on success.  */
 
 int
-xnanosleep (double seconds)
+xnanosleep_until (clockid_t clock, struct timespec const *deadline,
+                  double spin)
+{
+  return xnanosleep_until_stoppable (clock, deadline, spin, NULL);
+}
+
+/* Like xnanosleep_until, but give up early once *STOP (set by a signal
+   handler) is nonzero: return -1 with errno set to EINTR, instead of
+   sleeping on until DEADLINE.  STOP may be NULL.  */
+
+int
+xnanosleep_until_stoppable (clockid_t clock, struct timespec const *deadline,
+                            double spin, volatile sig_atomic_t const *stop)
+{
+  for (;;)
+    {
+      if (stop && *stop)
+        {
+          errno = EINTR;
+          return -1;
+        }
+
+      struct timespec now;
+      if (clock_gettime (clock, &now) != 0)
+        return -1;
+
+      double remaining = xtimespec_diff (&now, deadline);
+      if (remaining <= 0)
+        return 0;
+
+      /* Spinning: just read the clock again.  Should the clock step
+         back, REMAINING grows past SPIN and sleeping resumes.  */
+      if (remaining <= spin)
+        continue;
+
+      struct timespec wake = *deadline;
+      if (spin > 0)
+        {
+          wake = now;
+          xtimespec_add (&wake, remaining - spin);
+        }
+
+#ifdef TIMER_ABSTIME
+      int err = clock_nanosleep (clock, TIMER_ABSTIME, &wake, NULL);
+      if (err != 0 && err != EINTR)
+        {
+          errno = err;
+          return -1;
+        }
+#else
+      /* Without absolute sleeps, sleep for what's left and check.  */
+      double left = xtimespec_diff (&now, &wake);
+      struct timespec ts_sleep = { (time_t) left,
+                                   (long) ((left - (time_t) left) * 1e9) };
+      if (nanosleep (&ts_sleep, NULL) != 0 && errno != EINTR)
+        return -1;
+#endif
+    }
+}
+
+/* Sleep until SECONDS (non-negative) after the time this function is
+   called on CLOCK_MONOTONIC, spinning the last SPIN seconds.  If
+   SECONDS is so large that it is not representable as a 'struct
+   timespec', then use the maximum value for that interval.  Return -1
+   on failure (setting errno), 0 on success.  */
+
+int
+xnanosleep_spin (double seconds, double spin)
 {
 #if HAVE_PAUSE
   if (1.0 + TYPE_MAXIMUM (time_t) <= seconds)
@@ -45,26 +156,26 @@ xnanosleep (double seconds)
     }
 #endif
 
-  struct timespec ts_sleep = { (time_t)seconds, (long)((seconds - (time_t) seconds) * 1e9) };
-  for (;;)
-    {
-      /* Linux-2.6.8.1's nanosleep returns -1, but doesn't set errno
-         when resumed after being suspended.  Earlier versions would
-         set errno to EINTR.  nanosleep from linux-2.6.10, as well as
-         implementations by (all?) other vendors, doesn't return -1
-         in that case;  either it continues sleeping (if time remains)
-         or it returns zero (if the wake-up time has passed).
-
-         Gnulib's replacement nanosleep sometimes does not update
-         TS_SLEEP, and it is possible some kernels have a similar bug.
-         However, this merely causes xnanosleep to sleep longer than
-         necessary, which is not a correctness bug.  */
-      errno = 0;
-      if (nanosleep (&ts_sleep, &ts_sleep) == 0)
-        break;
-      if (errno != EINTR && errno != 0)
-        return -1;
-    }
+  struct timespec deadline;
+  if (clock_gettime (XNANOSLEEP_CLOCK, &deadline) != 0)
+    return -1;
+
+  /* One deadline for the whole sleep: restarting after a signal never
+     adds the time it took to handle it, unlike feeding the remaining
+     time of a relative nanosleep back to it.  */
+  xtimespec_add (&deadline, seconds);
+  return xnanosleep_until (XNANOSLEEP_CLOCK, &deadline, spin);
+}
 
-  return 0;
+/* Sleep until the time (call it WAKE_UP_TIME) specified as
+   SECONDS seconds after the time this function is called.
+   SECONDS must be non-negative.  If SECONDS is so large that
+   it is not representable as a 'struct timespec', then use
+   the maximum value for that interval.  Return -1 on failure
+   (setting errno), 0 on success.  */
+
+int
+xnanosleep (double seconds)
+{
+  return xnanosleep_spin (seconds, 0);
 }
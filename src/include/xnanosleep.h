@@ -14,11 +14,29 @@
    You should have received a copy of the GNU General Public License
    along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
+#include <signal.h>
+#include <time.h>
+
+/* The clock relative sleeps are measured on, immune to steps of the
+   wall clock where there is one.  */
+#ifdef CLOCK_MONOTONIC
+# define XNANOSLEEP_CLOCK CLOCK_MONOTONIC
+#else
+# define XNANOSLEEP_CLOCK CLOCK_REALTIME
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 int xnanosleep (double);
+int xnanosleep_spin (double, double);
+int xnanosleep_until (clockid_t, struct timespec const *, double);
+int xnanosleep_until_stoppable (clockid_t, struct timespec const *, double,
+                                volatile sig_atomic_t const *);
+
+double xtimespec_diff (struct timespec const *, struct timespec const *);
+void xtimespec_add (struct timespec *, double);
 
 #ifdef __cplusplus
 }
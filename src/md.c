@@ -14,6 +14,12 @@
    You should have received a copy of the GNU General Public License
    along with this program. If not, see <https://www.gnu.org/licenses/>. */
 /* Written by netheround <myemail@email.com> */
+/* gcc md.c -o md -pthread */
+
+/* O_PATH */
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
 
 #include <stdio.h>
 #include <stdbool.h>
@@ -25,8 +31,15 @@
 #include <sys/stat.h>
 #include <getopt.h>
 #include <limits.h> /* PATH_MAX */
+#include <fcntl.h>
 
+#include "include/config.h"
 #include "include/stripslash.c"
+#include "include/braceexp.c"
+
+#ifndef _WIN32
+# include "include/workpool.c"
+#endif /* _WIN32 */
 
 /* definitions */
 
@@ -36,8 +49,16 @@
 # define md_mkdir(path) (_mkdir(path))
 # define PATH_SEP "\\"
 #elif defined(__linux__)
-# define md_mkdir(path) (mkdir((path), \
-    S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IWGRP | S_IXGRP | S_IROTH | S_IXOTH))
+# define MD_MODE (S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IWGRP | S_IXGRP | S_IROTH | S_IXOTH)
+
+# define md_mkdir(path) (mkdir((path), MD_MODE))
+# define md_mkdirat(fd, name) (mkdirat((fd), (name), MD_MODE))
+/* mkdirat only needs to search the directory, not to read it */
+# ifdef O_PATH
+#  define md_opendirat(fd, name) (openat((fd), (name), O_PATH | O_DIRECTORY | O_CLOEXEC))
+# else
+#  define md_opendirat(fd, name) (openat((fd), (name), O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+# endif
 # define PATH_SEP "/"
 #endif /* _WIN32 */
 
@@ -53,40 +74,282 @@
 # define PATH_MAX PATH_MAX
 #endif /* PATH_MAX */
 
-// ...
+/* size of the buffer collecting verbose messages. */
+#define MD_OUTBUF_SIZE (64 * 1024)
 
-/* options */
+/* size of the buffer collecting failures while reading a manifest. */
+#define MANIFEST_BUFSIZ (64 * 1024)
+
+/* how many manifest entries between two progress lines. */
+#define MANIFEST_PROGRESS 65536
 
-/* flag set by '--help, --version'. */
-static int verbose_flag;
+/* how many cached parent fds `-p` keeps open at most. */
+#define MD_MAX_OPEN_DIRS 64
 
-/* parents option, see: `man 1 mkdir` */
-static bool is_parents = false;
+/* how many failures are spelled out before a manifest run only counts them. */
+#define MANIFEST_MAX_ERRORS 16
 
-/* verbose option, see: `man 1 mkdir` */
-static bool is_verbose = false;
+/* how many directories '--jobs' plans and creates at once. */
+#define MD_JOBS_BATCH 65536
 
-/* explicit verbose option expands the verbose message by displaying the current-working-path where it created it. */
-static bool explicit_verbose = false;
+// ...
+
+/* options */
+
+/* long options without a short equivalent. */
+enum
+{
+    FROM_STDIN_OPTION = CHAR_MAX + 1,
+    EXPAND_OPTION,
+    HELP_OPTION,
+    VERSION_OPTION
+};
 
-static struct option long_options[] = {
+static struct option const long_options[] = {
     /* these options set a flag. */
     {"verbose", no_argument, 0, 'v'},
     {"explicit", no_argument, 0, 'e'},
     {"parents", no_argument, 0, 'p'},
+    {"from-file", required_argument, 0, 'f'},
+    {"from-stdin", no_argument, 0, FROM_STDIN_OPTION},
+    {"null", no_argument, 0, 'z'},
+    {"jobs", required_argument, 0, 'j'},
+    {"expand", no_argument, 0, EXPAND_OPTION},
 
     /* these options don't set a flag. */
-    {"help", no_argument, &verbose_flag, 1},
-    {"version", no_argument, &verbose_flag, 2},
+    {"help", no_argument, 0, HELP_OPTION},
+    {"version", no_argument, 0, VERSION_OPTION},
 
     // terminating...
     {0, 0, 0, 0}
 };
 
+#ifndef _WIN32
+/* A directory known to exist, keyed by its parent and its name. Only parents
+   are remembered (never the leaves), so the table grows with the number of
+   distinct ancestors rather than with the number of directories created. */
+struct dir_node
+{
+    struct dir_node *parent;
+    size_t hash;
+
+    /* cached directory fd, -1 when it isn't open. */
+    int fd;
+
+    /* stored right after the node. */
+    char *name;
+};
+#endif /* _WIN32 */
+
+/* Everything a run of md works with, its options and what it learns along
+   the way. Nothing lives in file-static variables, so md can run more than
+   once in the same process, as a bash builtin for instance (see builtins.c). */
+struct md_state
+{
+    /* parents option, see: `man 1 mkdir` */
+    bool is_parents;
+
+    /* verbose option, see: `man 1 mkdir` */
+    bool is_verbose;
+
+    /* explicit verbose option expands the verbose message by displaying the current-working-path where it created it. */
+    bool explicit_verbose;
+
+    /* manifest option, a file (or '-' for stdin) listing the directories to create. */
+    const char *manifest;
+
+    /* manifest entries are terminated by NUL instead of newline. */
+    bool is_null_delim;
+
+    /* expand option, every DIRECTORY is a brace pattern like 'shard/{000..999}/{in,out}'. */
+    bool is_expand;
+
+    /* jobs option, number of threads creating directories at once. */
+    size_t jobs;
+
+    /* number of failures reported so far. */
+    size_t failures_reported;
+
+    /* number of directories handled so far, and how many of them failed. */
+    size_t dirs_total;
+    size_t dirs_failed;
+
+    /* verbose messages are collected here and written out in large chunks. */
+    char out_buf[MD_OUTBUF_SIZE];
+    size_t out_used;
+
+    /* failures while reading a manifest are collected here, like OUT_BUF. */
+    char err_buf[MANIFEST_BUFSIZ];
+    size_t err_used;
+
+    /* the current working directory, resolved once for '-e'. */
+    char *cwd;
+
+#ifndef _WIN32
+    /* relative paths start from the cwd, absolute ones from the root. */
+    struct dir_node cwd_root;
+    struct dir_node fs_root;
+
+    /* open addressing hash table of the known directories. */
+    struct dir_node **dir_table;
+    size_t dir_table_size;
+    size_t dir_table_used;
+
+    /* known directories currently holding an open fd. */
+    struct dir_node **open_dirs;
+    size_t open_dirs_used;
+    size_t open_dirs_size;
+
+    /* '--jobs' entries of the current batch, in the order they were given. */
+    char **batch;
+    size_t batch_used;
+#endif /* _WIN32 */
+};
+
 // ...
 
+static void
+fd_write (int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        buf += n;
+        len -= (size_t)n;
+    }
+}
+
+/* writes out the collected verbose messages. */
+static void
+out_flush (struct md_state *md)
+{
+    fd_write(STDOUT_FILENO, md->out_buf, md->out_used);
+    md->out_used = 0;
+}
+
+/* writes out the collected failures. */
+static void
+err_flush (struct md_state *md)
+{
+    fd_write(STDERR_FILENO, md->err_buf, md->err_used);
+    md->err_used = 0;
+}
+
+static void
+out_append (struct md_state *md, const char *s, size_t len)
+{
+    if (md->out_used + len > sizeof(md->out_buf))
+        out_flush(md);
+
+    if (len > sizeof(md->out_buf)) {
+        fd_write(STDOUT_FILENO, s, len);
+        return;
+    }
+
+    memcpy(md->out_buf + md->out_used, s, len);
+    md->out_used += len;
+}
+
+#define out_append_str(md, s) (out_append(md, (s), strlen(s)))
+
+/* prints why ACTION ("create", "open") failed on DIRNAME. While reading a
+   manifest, only the first few failures are printed, the rest are summarized. */
+static void
+report_failure (struct md_state *md, const char *action, const char *dirname, int err)
+{
+    if (md->manifest != NULL && md->failures_reported >= MANIFEST_MAX_ERRORS)
+        return;
+
+    md->failures_reported++;
+    if (md->manifest == NULL) {
+        fprintf(stderr, "%s: cannot %s directory '%s': %s\n", PROGRAM_NAME, action, dirname, strerror(err));
+        return;
+    }
+
+    /* batch the per-path errors into large writes */
+    size_t room = sizeof(md->err_buf) - md->err_used;
+    int len = snprintf(md->err_buf + md->err_used, room, "%s: cannot %s directory '%s': %s\n",
+        PROGRAM_NAME, action, dirname, strerror(err));
+    if (len >= 0 && (size_t)len < room) {
+        md->err_used += (size_t)len;
+        return;
+    }
+
+    err_flush(md);
+    fprintf(stderr, "%s: cannot %s directory '%s': %s\n", PROGRAM_NAME, action, dirname, strerror(err));
+}
+
+/* returns the current working directory, it doesn't change during a run, so
+   it is only looked up the first time. */
+static const char *
+current_cwd (struct md_state *md)
+{
+    if (md->cwd != NULL)
+        return md->cwd;
+
+    size_t size = PATH_MAX * sizeof(char);
+    char *cwd = (char *)malloc(size);
+    if (cwd == NULL) {
+        fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+        return NULL;
+    }
+
+    while (getcwd(cwd, size) == NULL) {
+        if (errno == ERANGE) {
+            /* Path is too long for allocated buffer, realloc with larger size */
+            size *= 2;
+            char *bigger = (char *)realloc(cwd, size);
+            if (bigger == NULL) {
+                fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+                free(cwd);
+                return NULL;
+            }
+            cwd = bigger;
+        } else {
+            fprintf(stderr, "%s: could not get current working directory: %s\n", PROGRAM_NAME, strerror(errno));
+            free(cwd);
+            return NULL;
+        }
+    }
+
+    md->cwd = cwd;
+    return md->cwd;
+}
+
+/* prints the verbose message for a freshly created DIRNAME, if asked to. */
+static int
+report_created (struct md_state *md, const char *dirname)
+{
+    if (md->explicit_verbose) {
+        const char *cwd = current_cwd(md);
+        if (cwd == NULL)
+            return -1;
+
+        out_append_str(md, PROGRAM_NAME);
+        out_append_str(md, ": created directory '");
+        out_append_str(md, dirname);
+        out_append_str(md, "' in: '");
+        out_append_str(md, cwd);
+        out_append_str(md, PATH_SEP);
+        out_append_str(md, dirname);
+        out_append_str(md, "'\n");
+    } else if (md->is_verbose) {
+        out_append_str(md, PROGRAM_NAME);
+        out_append_str(md, ": created directory '");
+        out_append_str(md, dirname);
+        out_append_str(md, "'\n");
+    }
+
+    return 0;
+}
+
 int
-make_dir (const char *dirname)
+make_dir (struct md_state *md, const char *dirname)
 {
     if (md_mkdir(dirname) == -1) {
         if (errno == EEXIST) {
@@ -94,51 +357,301 @@ make_dir (const char *dirname)
 
             return 0;
         } else {
-            fprintf(stderr, "%s: cannot create directory '%s': %s\n", PROGRAM_NAME, dirname, strerror(errno));
+            report_failure(md, "create", dirname, errno);
             return -1;
         }
     }
 
-    if (explicit_verbose) {
-        char *cwd = NULL;
-        size_t size = PATH_MAX * sizeof(char);
+    return report_created(md, dirname);
+}
 
-        cwd = (char *)malloc(size);
-        if (cwd == NULL) {
-            fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+#ifndef _WIN32
+static size_t
+dir_hash (const struct dir_node *parent, const char *name, size_t len)
+{
+    /* FNV-1a, seeded with the parent's hash. */
+    size_t hash = parent->hash ^ (size_t)14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= (size_t)1099511628211ULL;
+    }
+    return hash;
+}
+
+static struct dir_node *
+dir_lookup (struct md_state *md, struct dir_node *parent, const char *name, size_t len)
+{
+    if (md->dir_table_used == 0)
+        return NULL;
+
+    size_t hash = dir_hash(parent, name, len);
+    for (size_t i = hash & (md->dir_table_size - 1); md->dir_table[i] != NULL; i = (i + 1) & (md->dir_table_size - 1)) {
+        struct dir_node *node = md->dir_table[i];
+        if (node->hash == hash && node->parent == parent
+            && strncmp(node->name, name, len) == 0 && node->name[len] == '\0')
+            return node;
+    }
+    return NULL;
+}
+
+static bool
+dir_table_grow (struct md_state *md)
+{
+    size_t size = md->dir_table_size ? md->dir_table_size * 2 : 1024;
+    struct dir_node **table = (struct dir_node **)calloc(size, sizeof(*table));
+    if (table == NULL)
+        return false;
+
+    for (size_t i = 0; i < md->dir_table_size; i++) {
+        struct dir_node *node = md->dir_table[i];
+        if (node == NULL)
+            continue;
+
+        size_t j = node->hash & (size - 1);
+        while (table[j] != NULL)
+            j = (j + 1) & (size - 1);
+        table[j] = node;
+    }
+
+    free(md->dir_table);
+    md->dir_table = table;
+    md->dir_table_size = size;
+    return true;
+}
+
+/* remembers that NAME exists inside of PARENT, returns its node. */
+static struct dir_node *
+dir_insert (struct md_state *md, struct dir_node *parent, const char *name, size_t len)
+{
+    struct dir_node *node = dir_lookup(md, parent, name, len);
+    if (node != NULL)
+        return node;
+
+    /* keep the load factor under 1/2 */
+    if (2 * (md->dir_table_used + 1) > md->dir_table_size && !dir_table_grow(md)) {
+        fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+        return NULL;
+    }
+
+    node = (struct dir_node *)malloc(sizeof(*node) + len + 1);
+    if (node == NULL) {
+        fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+        return NULL;
+    }
+
+    node->parent = parent;
+    node->hash = dir_hash(parent, name, len);
+    node->fd = -1;
+    node->name = (char *)(node + 1);
+    memcpy(node->name, name, len);
+    node->name[len] = '\0';
+
+    size_t i = node->hash & (md->dir_table_size - 1);
+    while (md->dir_table[i] != NULL)
+        i = (i + 1) & (md->dir_table_size - 1);
+    md->dir_table[i] = node;
+    md->dir_table_used++;
+    return node;
+}
+
+/* remembers every component of DIRS as existing, starting from PARENT. */
+static struct dir_node *
+dir_insert_all (struct md_state *md, struct dir_node *parent, const char *dirs)
+{
+    while (parent != NULL && *dirs) {
+        while (*dirs == '/')
+            dirs++;
+
+        size_t len = strcspn(dirs, "/");
+        if (len == 0)
+            break;
+
+        parent = dir_insert(md, parent, dirs, len);
+        dirs += len;
+    }
+    return parent;
+}
+
+/* closes every cached fd, keeping the directories themselves known. */
+static void
+dir_close_all (struct md_state *md)
+{
+    for (size_t i = 0; i < md->open_dirs_used; i++) {
+        close(md->open_dirs[i]->fd);
+        md->open_dirs[i]->fd = -1;
+    }
+    md->open_dirs_used = 0;
+}
+
+/* forgets every known directory, closing their fds. */
+static void
+dir_forget_all (struct md_state *md)
+{
+    dir_close_all(md);
+
+    for (size_t i = 0; i < md->dir_table_size; i++)
+        free(md->dir_table[i]);
+    free(md->dir_table);
+    free(md->open_dirs);
+}
+
+/* returns a fd of NODE, opening it (and its parents) relative to the closest
+   open ancestor when it isn't cached yet. At most MD_MAX_OPEN_DIRS fds stay
+   cached, once there are that many the others get closed (and reopened on
+   demand), so the fd returned is only good until the next call. */
+static int
+dir_fd (struct md_state *md, struct dir_node *node)
+{
+    if (node->fd != -1)
+        return node->fd;
+
+    int fd;
+    if (node == &md->fs_root) {
+        fd = md_opendirat(AT_FDCWD, "/");
+    } else {
+        int parent_fd = dir_fd(md, node->parent);
+        if (parent_fd == -1)
+            return -1;
+        fd = md_opendirat(parent_fd, node->name);
+    }
+
+    if (fd == -1)
+        return -1;
+
+    /* the parent's fd isn't needed anymore, even when it was just opened */
+    if (md->open_dirs_used >= MD_MAX_OPEN_DIRS)
+        dir_close_all(md);
+
+    if (md->open_dirs_used == md->open_dirs_size) {
+        size_t size = md->open_dirs_size ? md->open_dirs_size * 2 : 64;
+        struct dir_node **dirs = (struct dir_node **)realloc(md->open_dirs, size * sizeof(*dirs));
+        if (dirs == NULL) {
+            close(fd);
+            errno = ENOMEM;
             return -1;
         }
 
-        while (getcwd(cwd, size) == NULL) {
-            if (errno == ERANGE) {
-                /* Path is too long for allocated buffer, realloc with larger size */
-                size *= 2;
-                cwd = (char *)realloc(cwd, size);
-                if (cwd == NULL) {
-                    fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
-                    return -1;
-                }
-            } else {
-                fprintf(stderr, "%s: could not get current working directory: %s\n", PROGRAM_NAME, strerror(errno));
-                free(cwd);
-                return -1;
-            }
+        md->open_dirs = dirs;
+        md->open_dirs_size = size;
+    }
+
+    node->fd = fd;
+    md->open_dirs[md->open_dirs_used++] = node;
+    return fd;
+}
+
+/* Creates PATH along with any missing parents. Ancestors that were already
+   seen during this run are skipped without a syscall, and the rest is created
+   relative to the fd of the deepest known one: the leaf is tried first, since
+   usually its parents already exist, otherwise we walk down from there, one
+   mkdirat and one openat of a single component per level, remembering every
+   parent. The cost stays linear in the depth, the leaf's try included. PATH
+   is modified temporarily, but restored before returning. */
+static int
+make_parents (struct md_state *md, char *path)
+{
+    struct dir_node *node = (*path == '/') ? &md->fs_root : &md->cwd_root;
+    char *p = path;
+
+    /* skip the known ancestors */
+    while (true) {
+        while (*p == '/')
+            p++;
+
+        char *end = p + strcspn(p, "/");
+        if (*end == '\0')
+            break;
+
+        struct dir_node *child = dir_lookup(md, node, p, end - p);
+        if (child == NULL)
+            break;
+
+        node = child;
+        p = end;
+    }
+
+    /* nothing left to create, PATH is the root itself */
+    char *rest = p;
+    if (*rest == '\0') {
+        if (*path == '/')
+            return 0;
+
+        report_failure(md, "create", path, ENOENT);
+        return -1;
+    }
+
+    int fd = dir_fd(md, node);
+    if (fd == -1) {
+        char saved = *rest;
+        *rest = '\0';
+        report_failure(md, "open", *path ? path : ".", errno);
+        *rest = saved;
+        return -1;
+    }
+
+    int leaf_status = md_mkdirat(fd, rest);
+    if (leaf_status == 0 || errno == EEXIST) {
+        if (leaf_status == 0 && report_created(md, path) == -1)
+            return -1;
+
+        /* all the parents exist, remember them */
+        char *slash = strrchr(rest, '/');
+        if (slash != NULL) {
+            *slash = '\0';
+            node = dir_insert_all(md, node, rest);
+            *slash = '/';
         }
+        return node == NULL ? -1 : 0;
+    }
 
-        printf("%s: created directory '%s' in: '%s%s%s'\n", PROGRAM_NAME, dirname, cwd, PATH_SEP, dirname);
-        free(cwd);
-    } else if (is_verbose) {
-        printf("%s: created directory '%s'\n", PROGRAM_NAME, dirname);
+    /* a missing parent, or too long a path to resolve at once */
+    if (errno != ENOENT && errno != ENAMETOOLONG) {
+        report_failure(md, "create", path, errno);
+        return -1;
     }
 
-    return 0;
+    p = rest;
+    /* walking down from the deepest known ancestor, remembering each parent. */
+    while (true) {
+        while (*p == '/')
+            p++;
+
+        char *next = p + strcspn(p, "/");
+        char saved = *next;
+        *next = '\0';
+
+        int status = 0;
+        fd = dir_fd(md, node);
+        if (fd == -1) {
+            report_failure(md, "open", path, errno);
+            status = -1;
+        } else if (md_mkdirat(fd, p) == 0) {
+            status = report_created(md, path);
+        } else if (errno != EEXIST) {
+            report_failure(md, "create", path, errno);
+            status = -1;
+        }
+
+        /* the leaf doesn't need to be remembered. */
+        if (status == 0 && saved != '\0')
+            node = dir_insert(md, node, p, next - p);
+        *next = saved;
+
+        if (status == -1 || node == NULL)
+            return -1;
+        if (saved == '\0')
+            return 0;
+
+        p = next;
+    }
 }
+#endif /* _WIN32 */
 
 int
-create_dir (const char *dirname)
+create_dir (struct md_state *md, const char *dirname)
 {
     /* handling parented directories */
-    if (is_parents) {
+    if (md->is_parents) {
         char *dir_cpy = strdup(dirname);
         if (dir_cpy == NULL) {
             fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
@@ -148,34 +661,583 @@ create_dir (const char *dirname)
         /* Normalize directory path */
         strip_trailing_slashes(dir_cpy);
 
+#ifdef _WIN32
         char *slash = dir_cpy;
         while ((slash = strchr(slash + 1, '/')) != NULL) {
             /* Null terminate at the last '/ */
             *slash = '\0';
 
-            make_dir(dir_cpy);
+            make_dir(md, dir_cpy);
             *slash = '/';
         }
         free(dir_cpy);
+#else
+        int status = make_parents(md, dir_cpy);
+        free(dir_cpy);
+        return status;
+#endif /* _WIN32 */
+    }
+    return make_dir(md, dirname);
+}
+
+#ifndef _WIN32
+/* A single mkdir of a '--jobs' batch, either an entry or, with '-p', one of
+   its parents. PATH points into the entry and isn't NUL-terminated. */
+struct md_task
+{
+    const char *path;
+    size_t len;
+
+    /* the tasks of a level run together, once the previous level is done:
+       with '-p' the level is the depth of PATH, otherwise see plan_levels. */
+    size_t level;
+
+    /* 0 once created, otherwise the errno of mkdir. */
+    int err;
+    bool reported;
+
+    /* with '-p', the task of the parent directory, NULL when it was known
+       before the batch. The tasks of the next level create their directory
+       relative to FD, open while they run (-1 if it couldn't be opened). */
+    struct md_task *parent;
+    int fd;
+    bool is_parent;
+};
+
+/* a path of the level being planned, or a parent of one, see plan_levels. */
+struct level_key
+{
+    const char *path;
+    size_t len;
+    size_t hash;
+
+    /* the level it belongs to, a slot of an older level counts as empty. */
+    size_t level;
+    bool is_entry;
+};
+
+/* returns the end of the DEPTH-th component of PATH, or NULL if PATH is shallower. */
+static const char *
+component_end (const char *path, size_t depth)
+{
+    const char *p = path;
+    for (size_t i = 0; i < depth; i++) {
+        while (*p == '/')
+            p++;
+        if (*p == '\0')
+            return NULL;
+        p += strcspn(p, "/");
     }
-    return make_dir(dirname);
+    return p;
+}
+
+static size_t
+path_depth (const char *path)
+{
+    size_t depth = 0;
+    while (component_end(path, depth + 1) != NULL)
+        depth++;
+    return depth;
 }
 
-void
+/* tasks are ordered by level first, so every level runs before the next one. */
+static int
+task_cmp (const void *a, const void *b)
+{
+    const struct md_task *x = (const struct md_task *)a;
+    const struct md_task *y = (const struct md_task *)b;
+
+    if (x->level != y->level)
+        return x->level < y->level ? -1 : 1;
+
+    int cmp = memcmp(x->path, y->path, x->len < y->len ? x->len : y->len);
+    if (cmp != 0)
+        return cmp;
+    return (x->len > y->len) - (x->len < y->len);
+}
+
+static struct md_task *
+task_find (struct md_task *tasks, size_t ntasks, const char *path, size_t len, size_t level)
+{
+    struct md_task key = { path, len, level, 0, false, NULL, -1, false };
+    return (struct md_task *)bsearch(&key, tasks, ntasks, sizeof(*tasks), task_cmp);
+}
+
+static bool
+task_failed (const struct md_task *task)
+{
+    return task->err != 0 && task->err != EEXIST;
+}
+
+/* returns the key PATH of LEVEL in TABLE (of MASK + 1 slots), or the empty
+   slot where it goes. */
+static struct level_key *
+level_slot (struct level_key *table, size_t mask, const char *path, size_t len, size_t level)
+{
+    /* FNV-1a */
+    size_t hash = (size_t)14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)path[i];
+        hash *= (size_t)1099511628211ULL;
+    }
+
+    size_t i = hash & mask;
+    for (; table[i].level == level; i = (i + 1) & mask) {
+        if (table[i].hash == hash && table[i].len == len && memcmp(table[i].path, path, len) == 0)
+            return &table[i];
+    }
+
+    table[i].path = path;
+    table[i].len = len;
+    table[i].hash = hash;
+    table[i].is_entry = false;
+    return &table[i];
+}
+
+/* Without '-p' every entry is a single task, and the entries are cut, in
+   their order, into levels of entries that don't depend on each other: an
+   entry starts a new level when the current one already has the same path,
+   one of its parents or one of its children, whose mkdir a serial run would
+   have done first. Paths are compared by their components, "a//b/" is "a/b".
+   Returns -1 when out of memory. */
+static int
+plan_levels (struct md_state *md, struct md_task *tasks)
+{
+    size_t total = 0;
+    size_t keys = 0;
+    for (size_t i = 0; i < md->batch_used; i++) {
+        total += strlen(md->batch[i]) + 1;
+        keys += path_depth(md->batch[i]) + 1;
+    }
+
+    /* under half full, so the probing always ends */
+    size_t size = 64;
+    while (size < 2 * keys)
+        size *= 2;
+
+    char *paths = (char *)malloc(total);
+    struct level_key *table = (struct level_key *)calloc(size, sizeof(*table));
+    if (paths == NULL || table == NULL) {
+        free(paths);
+        free(table);
+        return -1;
+    }
+
+    /* levels start at 1, the slots that were never used are at 0 */
+    size_t level = 1;
+    char *path = paths;
+    for (size_t i = 0; i < md->batch_used; i++) {
+        const char *entry = md->batch[i];
+
+        size_t len = 0;
+        for (const char *p = entry; *p != '\0'; p++)
+            if (*p != '/' || len == 0 || path[len - 1] != '/')
+                path[len++] = *p;
+        if (len > 1 && path[len - 1] == '/')
+            len--;
+        path[len] = '\0';
+
+        /* the same path or a child of it, then one of its parents */
+        bool is_dependent = level_slot(table, size - 1, path, len, level)->level == level;
+        for (size_t k = 1; k < len && !is_dependent; k++) {
+            if (path[k] != '/')
+                continue;
+
+            struct level_key *key = level_slot(table, size - 1, path, k, level);
+            is_dependent = key->level == level && key->is_entry;
+        }
+
+        if (is_dependent)
+            level++;
+
+        for (size_t k = 1; k < len; k++) {
+            if (path[k] == '/')
+                level_slot(table, size - 1, path, k, level)->level = level;
+        }
+
+        struct level_key *key = level_slot(table, size - 1, path, len, level);
+        key->level = level;
+        key->is_entry = true;
+
+        struct md_task task = { entry, strlen(entry), level, 0, false, NULL, -1, false };
+        tasks[i] = task;
+        path += len + 1;
+    }
+
+    free(table);
+    free(paths);
+    return 0;
+}
+
+static void
+run_task (void *ctx, size_t index)
+{
+    struct md_task *task = &((struct md_task *)ctx)[index];
+    char buf[PATH_MAX];
+    char *path = buf;
+
+    if (task->len >= sizeof(buf)) {
+        path = (char *)malloc(task->len + 1);
+        if (path == NULL) {
+            task->err = ENOMEM;
+            return;
+        }
+    }
+
+    memcpy(path, task->path, task->len);
+    path[task->len] = '\0';
+
+    /* relative to the parent created by the previous level, a single lookup */
+    int dir_fd = AT_FDCWD;
+    char *name = path;
+    if (task->parent != NULL && task->parent->fd != -1) {
+        dir_fd = task->parent->fd;
+        for (name = path + task->parent->len; *name == '/'; name++)
+            ;
+    }
+
+    task->err = md_mkdirat(dir_fd, name) == 0 ? 0 : errno;
+    if (task->is_parent && (task->err == 0 || task->err == EEXIST))
+        task->fd = md_opendirat(dir_fd, name);
+
+    if (path != buf)
+        free(path);
+}
+
+/* Reports the results of ENTRY the way a serial run would have: first its
+   parents created by this batch, then the entry itself, or the failure a
+   serial run would have hit. TASK is the entry's, or NULL to look it up. */
+static void
+replay_entry (struct md_state *md, char *entry, struct md_task *task, struct md_task *tasks, size_t ntasks)
+{
+    size_t depth = path_depth(entry);
+
+    for (size_t k = 1; md->is_parents && k < depth; k++) {
+        char *end = (char *)component_end(entry, k);
+        struct md_task *parent = task_find(tasks, ntasks, entry, end - entry, k);
+        if (parent == NULL || parent->reported)
+            continue;
+
+        parent->reported = true;
+        if (parent->err == 0) {
+            char saved = *end;
+            *end = '\0';
+            report_created(md, entry);
+            *end = saved;
+        }
+    }
+
+    if (task == NULL)
+        task = task_find(tasks, ntasks, entry, strlen(entry), depth);
+
+    md->dirs_total++;
+    if (task_failed(task)) {
+        /* a missing parent: serial walks down and reports the first one
+           that failed, with its own errno */
+        char *end = entry + strlen(entry);
+        int err = task->err;
+        bool is_walked = md->is_parents && (err == ENOENT || err == ENAMETOOLONG);
+        for (size_t k = 1; is_walked && k < depth; k++) {
+            char *parent_end = (char *)component_end(entry, k);
+            struct md_task *parent = task_find(tasks, ntasks, entry, parent_end - entry, k);
+            if (parent != NULL && task_failed(parent)) {
+                end = parent_end;
+                err = parent->err;
+                break;
+            }
+        }
+
+        char saved = *end;
+        *end = '\0';
+        report_failure(md, "create", entry, err);
+        *end = saved;
+        md->dirs_failed++;
+        return;
+    }
+
+    /* like make_dir, a message that can't be printed ('-e') counts as a failure */
+    if (!task->reported && task->err == 0 && report_created(md, entry) == -1)
+        md->dirs_failed++;
+    task->reported = true;
+
+    /* its parents surely exist now */
+    if (md->is_parents && depth > 1) {
+        char *end = (char *)component_end(entry, depth - 1);
+        char saved = *end;
+        *end = '\0';
+        dir_insert_all(md, (*entry == '/') ? &md->fs_root : &md->cwd_root, entry);
+        *end = saved;
+    }
+}
+
+/* Creates the queued batch. With '-p' every entry and every parent that
+   isn't known yet becomes a task, tasks are grouped by depth, and each level
+   runs on the pool once the previous one is done, so parents always come
+   before their children while siblings go in parallel. Without '-p' the
+   levels keep an entry after the ones it depends on, see plan_levels. The
+   results are reported afterwards, in the order of the entries, so the
+   output doesn't depend on the scheduling. Like without '--jobs', every
+   entry is attempted and a failing one is only counted, -1 is returned
+   when out of memory. */
+static int
+batch_flush (struct md_state *md)
+{
+    if (md->batch_used == 0)
+        return 0;
+
+    size_t ntasks = 0;
+    for (size_t i = 0; i < md->batch_used; i++)
+        ntasks += md->is_parents ? path_depth(md->batch[i]) + 1 : 1;
+
+    struct md_task *tasks = (struct md_task *)malloc(ntasks * sizeof(*tasks));
+    if (tasks == NULL) {
+        fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+        return -1;
+    }
+
+    if (!md->is_parents) {
+        if (plan_levels(md, tasks) == -1) {
+            fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+            free(tasks);
+            return -1;
+        }
+        ntasks = md->batch_used;
+    } else {
+        ntasks = 0;
+        for (size_t i = 0; i < md->batch_used; i++) {
+            const char *entry = md->batch[i];
+            size_t depth = path_depth(entry);
+
+            /* the known parents don't need a task */
+            struct dir_node *node = (*entry == '/') ? &md->fs_root : &md->cwd_root;
+            const char *start = entry;
+            size_t k = 1;
+
+            for (; k < depth && node != NULL; k++) {
+                const char *end = component_end(entry, k);
+                while (*start == '/')
+                    start++;
+
+                node = dir_lookup(md, node, start, end - start);
+                if (node == NULL)
+                    break;
+                start = end;
+            }
+
+            for (; k < depth; k++) {
+                struct md_task task = { entry, component_end(entry, k) - entry, k, 0, false, NULL, -1, false };
+                tasks[ntasks++] = task;
+            }
+
+            struct md_task task = { entry, strlen(entry), depth, 0, false, NULL, -1, false };
+            tasks[ntasks++] = task;
+        }
+
+        qsort(tasks, ntasks, sizeof(*tasks), task_cmp);
+
+        /* drop the duplicates */
+        size_t unique = 0;
+        for (size_t i = 0; i < ntasks; i++)
+            if (unique == 0 || task_cmp(&tasks[unique - 1], &tasks[i]) != 0)
+                tasks[unique++] = tasks[i];
+        ntasks = unique;
+
+        /* the parent of a task is the task of its prefix, if there is one */
+        for (size_t i = 0; i < ntasks; i++) {
+            struct md_task *task = &tasks[i];
+            if (task->level < 2)
+                continue;
+
+            const char *end = component_end(task->path, task->level - 1);
+            task->parent = task_find(tasks, ntasks, task->path, end - task->path, task->level - 1);
+            if (task->parent != NULL)
+                task->parent->is_parent = true;
+        }
+    }
+
+    for (size_t begin = 0, prev = 0, end; begin < ntasks; prev = begin, begin = end) {
+        for (end = begin; end < ntasks && tasks[end].level == tasks[begin].level; end++)
+            ;
+        workpool_run(md->jobs, end - begin, run_task, tasks + begin);
+
+        /* the previous level's fds were only needed by this one */
+        for (size_t i = prev; i < begin; i++) {
+            if (tasks[i].fd != -1)
+                close(tasks[i].fd);
+            tasks[i].fd = -1;
+        }
+    }
+
+    for (size_t i = 0; i < ntasks; i++)
+        if (tasks[i].fd != -1)
+            close(tasks[i].fd);
+
+    for (size_t i = 0; i < md->batch_used; i++)
+        replay_entry(md, md->batch[i], md->is_parents ? NULL : &tasks[i], tasks, ntasks);
+
+    /* tasks point into every entry, free them only once all are reported */
+    for (size_t i = 0; i < md->batch_used; i++)
+        free(md->batch[i]);
+
+    free(tasks);
+    md->batch_used = 0;
+    return 0;
+}
+
+/* queues DIRNAME into the current batch, creating the batch once it's full. */
+static int
+batch_add (struct md_state *md, const char *dirname)
+{
+    if (md->batch == NULL) {
+        md->batch = (char **)malloc(MD_JOBS_BATCH * sizeof(*md->batch));
+        if (md->batch == NULL) {
+            fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+            return -1;
+        }
+    }
+
+    char *entry = strdup(dirname);
+    if (entry == NULL) {
+        fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+        return -1;
+    }
+
+    if (md->is_parents)
+        strip_trailing_slashes(entry);
+
+    md->batch[md->batch_used++] = entry;
+    return md->batch_used == MD_JOBS_BATCH ? batch_flush(md) : 0;
+}
+#endif /* _WIN32 */
+
+/* Hands DIRNAME over to be created, right away or, with '--jobs', as part of
+   the current batch. Returns -1 when DIRNAME couldn't be created, a queued
+   directory only fails that way if it couldn't be queued at all, or if the
+   batch it completed ran out of memory. */
+static int
+submit_one (struct md_state *md, const char *dirname)
+{
+#ifndef _WIN32
+    if (md->jobs > 1)
+        return batch_add(md, dirname);
+#endif /* _WIN32 */
+
+    md->dirs_total++;
+    if (create_dir(md, dirname) == -1) {
+        md->dirs_failed++;
+        return -1;
+    }
+    return 0;
+}
+
+/* Like submit_one, but with '--expand' DIRNAME is a pattern whose expansions
+   are generated one at a time, so even a million of them never sit in
+   memory together. Like operands, every expansion is attempted. */
+static int
+submit_dir (struct md_state *md, const char *dirname)
+{
+    if (!md->is_expand)
+        return submit_one(md, dirname);
+
+    struct brace_pattern pattern;
+    if (brace_parse(&pattern, dirname) == -1) {
+        fprintf(stderr, "%s: invalid pattern '%s'\n", PROGRAM_NAME, dirname);
+        md->dirs_total++;
+        md->dirs_failed++;
+        return -1;
+    }
+
+    int status = 0;
+    const char *name;
+    while ((name = brace_next(&pattern)) != NULL) {
+        if (submit_one(md, name) == -1)
+            status = -1;
+    }
+
+    brace_free(&pattern);
+    return status;
+}
+
+/* Creates every directory listed in FILENAME ('-' for stdin), one entry per
+   line (or per NUL with '-z'). Entries are streamed through a single reused
+   buffer, so memory stays bounded by the longest path, not the entry count.
+   Like operands, a failing entry doesn't stop the run, the failures are
+   counted and summarized by main. */
+static int
+create_from_manifest (struct md_state *md, const char *filename)
+{
+    FILE *stream = stdin;
+    if (strcmp(filename, "-") != 0) {
+        stream = fopen(filename, "r");
+        if (stream == NULL) {
+            fprintf(stderr, "%s: cannot open '%s': %s\n", PROGRAM_NAME, filename, strerror(errno));
+            return -1;
+        }
+    }
+
+    bool show_progress = isatty(STDERR_FILENO);
+    int delim = md->is_null_delim ? '\0' : '\n';
+    char *line = NULL;
+    size_t size = 0;
+    size_t entries = 0;
+    ssize_t len;
+    int status = 0;
+
+    while ((len = getdelim(&line, &size, delim, stream)) != -1) {
+        if (len > 0 && line[len - 1] == delim)
+            line[--len] = '\0';
+
+        /* skip blank entries */
+        if (len == 0)
+            continue;
+
+        /* a queued entry only fails when the batch itself failed */
+        if (submit_dir(md, line) == -1 && md->jobs > 1) {
+            status = -1;
+            break;
+        }
+
+        if (show_progress && ++entries % MANIFEST_PROGRESS == 0) {
+            err_flush(md);
+            fprintf(stderr, "%s: %zu entries processed, %zu failed\n", PROGRAM_NAME, md->dirs_total, md->dirs_failed);
+        }
+    }
+
+    if (ferror(stream)) {
+        err_flush(md);
+        fprintf(stderr, "%s: error reading '%s': %s\n", PROGRAM_NAME, filename, strerror(errno));
+        status = -1;
+    }
+
+    free(line);
+    if (stream != stdin)
+        fclose(stream);
+    return status;
+}
+
+int
 usage (int status)
 {
     if (status != EXIT_SUCCESS) {
         printf("Try '%s --help' for more information.\n", PROGRAM_NAME);
-        exit(status);
+        return status;
     }
 
     printf("Usage: %s [OPTION]... DIRECTORY...\n"
-    "Create the DIRECTORY(ies), if they do not already exist.\n\n", PROGRAM_NAME);
+    "  or:  %s [OPTION]... -f FILE\n"
+    "Create the DIRECTORY(ies), if they do not already exist. Every DIRECTORY\n"
+    "is attempted, even if an earlier one fails.\n\n", PROGRAM_NAME, PROGRAM_NAME);
 
     puts("Options:\n"
     "  -p, --parents\t\tno error if existing, make parent directories as needed\n"
     "  -v, --verbose\t\tprint a message for each created directory\n"
-    "  -e, --explicit\tsimilar to '-v, --verbose', prints a message with more explicit information.\n\n"
+    "  -e, --explicit\tsimilar to '-v, --verbose', prints a message with more explicit information.\n"
+    "  -f, --from-file=FILE\tread the directories from FILE, one per line, '-' means stdin\n"
+    "      --from-stdin\tsame as '--from-file=-'\n"
+    "  -z, --null\t\tentries of FILE are terminated by NUL, not newline\n"
+    "  -j, --jobs=N\t\tcreate up to N directories at once, parents still come first\n"
+    "      --expand\t\ttreat every DIRECTORY as a pattern of '{a,b}' lists\n"
+    "\t\t\tand '{000..999}' ranges, expanded without the shell\n\n"
     
     "      --help\t\tdisplay this help and exit\n"
     "      --version\toutput version information and exit\n");
@@ -183,11 +1245,13 @@ usage (int status)
     printf("Examples:\n"
     "  %s test      -> creates directory 'test' if it doesn't exist.\n"
     "  %s a b c     -> creates directories 'a', 'b', 'c', if they do not exist aleardy.\n"
-    "  %s -ep a/b   -> creates directories 'a' and 'b' inside of 'a' while printing a message for each created directory.\n", PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME);
-    exit(status);
+    "  %s -ep a/b   -> creates directories 'a' and 'b' inside of 'a' while printing a message for each created directory.\n"
+    "  find src -type d -print0 | %s -pz --from-stdin   -> creates every listed directory.\n"
+    "  %s -p --expand 'shard/{000..999}/{in,out}'   -> creates 2000 directories and their parents.\n", PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME);
+    return status;
 }
 
-void
+int
 version_info()
 {
     printf("%s (EWE Coreutils) 0.0.2\n"
@@ -195,59 +1259,130 @@ version_info()
     "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
     "This is free software: you are free to change and redistribute it.\n"
     "\nWritten by %s\n", PROGRAM_NAME, AUTHOR);
-    exit(EXIT_SUCCESS);
+    return EXIT_SUCCESS;
+}
+
+/* writes out what is still buffered and releases everything MD holds. */
+static void
+md_cleanup (struct md_state *md)
+{
+    out_flush(md);
+    err_flush(md);
+    free(md->cwd);
+
+#ifndef _WIN32
+    for (size_t i = 0; i < md->batch_used; i++)
+        free(md->batch[i]);
+    free(md->batch);
+    dir_forget_all(md);
+#endif /* _WIN32 */
+
+    free(md);
 }
 
+/* Runs md with ARGV and returns its exit status, without ever exiting. */
 int
-main (int argc, char **argv)
+md_run (int argc, char **argv)
 {
+    struct md_state *md = (struct md_state *)calloc(1, sizeof(*md));
+    if (md == NULL) {
+        fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+        return EXIT_FAILURE;
+    }
+
+    md->jobs = 1;
+#ifndef _WIN32
+    md->cwd_root.fd = AT_FDCWD;
+    md->cwd_root.name = "";
+    md->fs_root.hash = 1;
+    md->fs_root.fd = -1;
+    md->fs_root.name = "";
+#endif /* _WIN32 */
+
+    /* flag set by '--help, --version'. */
+    int verbose_flag = 0;
+    int status = EXIT_SUCCESS;
     int c;
+
+    reset_getopt();
     while (true) {
         int option_ind = 0;
-        c = getopt_long(argc, argv, "vep", long_options, &option_ind);
+        c = getopt_long(argc, argv, "vepf:zj:", long_options, &option_ind);
 
         if (c == -1)
             break;
         
         switch (c)
         {
-            case 0:
-                if (long_options[option_ind].flag != 0)
-                    break;
-                printf("option %s", long_options[option_ind].name);
-                if (optarg)
-                    printf(" with arg %s\n", optarg);
-                break;
-            
             case 'v':
-                is_verbose = true;
+                md->is_verbose = true;
                 break;
             
             case 'e':
-                explicit_verbose = true;
+                md->explicit_verbose = true;
                 break;
 
             case 'p':
-                is_parents = true;
+                md->is_parents = true;
+                break;
+
+            case 'f':
+                md->manifest = optarg;
+                break;
+
+            case FROM_STDIN_OPTION:
+                md->manifest = "-";
+                break;
+
+            case 'z':
+                md->is_null_delim = true;
+                break;
+
+            case EXPAND_OPTION:
+                md->is_expand = true;
+                break;
+
+            case 'j': {
+                char *endptr;
+                errno = 0;
+                long n = strtol(optarg, &endptr, 10);
+                if (endptr == optarg || *endptr || errno == ERANGE || n < 1) {
+                    fprintf(stderr, "%s: invalid number of jobs '%s'\n", PROGRAM_NAME, optarg);
+                    status = usage(EXIT_FAILURE);
+                    goto done;
+                }
+                md->jobs = (size_t)n;
+                break;
+            }
+
+            case HELP_OPTION:
+                verbose_flag = 1;
+                break;
+
+            case VERSION_OPTION:
+                verbose_flag = 2;
                 break;
 
             case '?':
                 /* getopt_long aleardy printed an error message. */
 
-                usage(EXIT_FAILURE);
-                break;
+                status = usage(EXIT_FAILURE);
+                goto done;
 
             default:
-                usage(2);
+                status = usage(2);
+                goto done;
         }
     };
 
     switch (verbose_flag)
     {
         case 1:
-            usage(EXIT_SUCCESS);
+            status = usage(EXIT_SUCCESS);
+            goto done;
         case 2:
-            version_info();
+            status = version_info();
+            goto done;
     }
 
     /* create directories from command line arguments */
@@ -256,13 +1391,41 @@ main (int argc, char **argv)
             /* succesfully creating directories */
 
             const char *dirname = argv[optind++];
-            if (create_dir(dirname) == -1)
-                exit(EXIT_FAILURE);
+            if (submit_dir(md, dirname) == -1)
+                status = EXIT_FAILURE;
         }
-    } else if (argc == 1) {
+    } else if (md->manifest == NULL) {
         printf("%s: missing operand\n", PROGRAM_NAME);
-        usage(EXIT_FAILURE);
+        status = usage(EXIT_FAILURE);
+        goto done;
     }
 
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    /* create directories listed in the manifest */
+    if (md->manifest != NULL && create_from_manifest(md, md->manifest) == -1)
+        status = EXIT_FAILURE;
+
+#ifndef _WIN32
+    if (batch_flush(md) == -1)
+        status = EXIT_FAILURE;
+#endif /* _WIN32 */
+
+    err_flush(md);
+    if (md->dirs_failed) {
+        if (md->manifest != NULL) {
+            if (md->dirs_failed > md->failures_reported)
+                fprintf(stderr, "%s: %zu more failures not shown\n", PROGRAM_NAME, md->dirs_failed - md->failures_reported);
+            fprintf(stderr, "%s: %zu of %zu directories could not be created\n", PROGRAM_NAME, md->dirs_failed, md->dirs_total);
+        }
+        status = EXIT_FAILURE;
+    }
+
+done:
+    md_cleanup(md);
+    return status;
+}
+
+int
+main (int argc, char **argv)
+{
+    return md_run(argc, argv);
+}
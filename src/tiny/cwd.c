@@ -0,0 +1,140 @@
+/* cwd -- print the name of the current working directory (startup-minimal build)
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* Written by netheround <myemail@email.com> */
+/* gcc -Os -static -nostdlib -fno-stack-protector -fno-asynchronous-unwind-tables tiny/cwd.c -o cwd */
+
+/* Behaves exactly like ../cwd.c, see ../include/tiny.c. */
+
+#include "../include/tiny.c"
+
+/* definitions */
+#define PROGRAM_NAME "cwd"
+#define AUTHOR "netheround"
+
+/* options */
+
+/* long options without a short equivalent. */
+enum
+{
+    HELP_OPTION = 256,
+    VERSION_OPTION
+};
+
+static const struct tiny_option long_options[] = {
+    {"physical", false, 'P'},
+    {"logical", false, 'L'},
+    {"help", false, HELP_OPTION},
+    {"version", false, VERSION_OPTION},
+
+    // terminating...
+    {0, 0, 0}
+};
+
+/* every text is a single literal, written out with a single write(2). */
+
+static const char try_text[] =
+    "Try '" PROGRAM_NAME " --help' for more information.\n";
+
+static const char usage_text[] =
+    "Usage " PROGRAM_NAME " [OPTION]...\n"
+    "Print the name of the current working directory.\n\n"
+    "Options\n"
+    "  -L, --logical\t\tuse PWD from environment, only if your system has it.\n"
+    "  -P, --physical\tavoid all symlinks\n"
+    "      --help\t\tdisplay this help and exit\n"
+    "      --version\t\toutput version information and exit\n\n"
+    "By default, '" PROGRAM_NAME "' behaves as if '-L' were specified.\n"
+    "Examples:\n"
+    "  " PROGRAM_NAME " -L    -> print the current working directory using PWD.\n"
+    "  " PROGRAM_NAME "       -> print the current working directory.\n";
+
+static const char version_text[] =
+    PROGRAM_NAME " (EWE Coreutils) 0.0.1\n"
+    "Copyright (C) 2024\n"
+    "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
+    "This is free software: you are free to change and redistribute it.\n"
+    "\nWritten by " AUTHOR "\n";
+
+int
+main (int argc, char **argv)
+{
+    /* flag set by '--help, --version'. */
+    int verbose_flag = 0;
+
+    /* logical, physical modes, read more: https://en.wikipedia.org/wiki/Pwd */
+    bool is_logical = false;
+
+    struct tiny_getopt opts = {0};
+    int c;
+    while ((c = tiny_getopt(&opts, argc, argv, "LP", long_options)) != -1) {
+        switch (c)
+        {
+            case HELP_OPTION:
+                verbose_flag = 1;
+                break;
+
+            case VERSION_OPTION:
+                verbose_flag = 2;
+                break;
+
+            case 'L':
+                is_logical = true;
+                break;
+
+            case 'P':
+                is_logical = false;
+                break;
+
+            default:
+                /* tiny_getopt aleardy printed an error message. */
+                tiny_write(STDOUT_FILENO, try_text, sizeof(try_text) - 1);
+                return EXIT_FAILURE;
+        }
+    }
+
+    switch (verbose_flag)
+    {
+        case 1:
+            tiny_write(STDOUT_FILENO, usage_text, sizeof(usage_text) - 1);
+            return EXIT_SUCCESS;
+        case 2:
+            tiny_write(STDOUT_FILENO, version_text, sizeof(version_text) - 1);
+            return EXIT_SUCCESS;
+    }
+
+    /* main logic */
+
+    if (is_logical) {
+        const char *pwd = tiny_getenv("PWD");
+        if (pwd == NULL) {
+            tiny_print(STDERR_FILENO, PROGRAM_NAME ": 'PWD' environment variable not found.\n", NULL);
+            return EXIT_FAILURE;
+        }
+        return tiny_print(STDOUT_FILENO, pwd, "\n", NULL) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /* the directory and its newline, written at once */
+    char cwd[PATH_MAX + 1];
+    if (tiny_getcwd(cwd, PATH_MAX) == NULL) {
+        tiny_print(STDERR_FILENO, PROGRAM_NAME ": error fetching current working directory: ",
+            tiny_strerror(tiny_errno), "\n", NULL);
+        return EXIT_FAILURE;
+    }
+
+    size_t len = strlen(cwd);
+    cwd[len] = '\n';
+    return tiny_write(STDOUT_FILENO, cwd, len + 1) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
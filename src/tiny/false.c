@@ -0,0 +1,21 @@
+/* false -- do nothing, unsuccessfully (startup-minimal build)
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* Written by netheround <myemail@email.com> */
+/* gcc -Os -static -nostdlib -fno-stack-protector -fno-asynchronous-unwind-tables tiny/false.c -o false */
+
+/* define failure exit code for false. */
+#define EXIT_STATUS 1
+#include "true.c"
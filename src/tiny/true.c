@@ -0,0 +1,77 @@
+/* true -- do nothing, successfully (startup-minimal build)
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* Written by netheround <myemail@email.com> */
+/* gcc -Os -static -nostdlib -fno-stack-protector -fno-asynchronous-unwind-tables tiny/true.c -o true */
+
+/* Behaves exactly like ../true.c, see ../include/tiny.c. */
+
+#include "../include/tiny.c"
+
+/* false.c overrides this, acts like "true" by default. */
+#ifndef EXIT_STATUS
+# define EXIT_STATUS EXIT_SUCCESS
+#endif /* EXIT_STATUS */
+
+#if EXIT_STATUS == EXIT_SUCCESS
+# define PROGRAM_NAME "true"
+# define STATUS "success"
+# define STATUS_CODE "0"
+#else
+# define PROGRAM_NAME "false"
+# define STATUS "failure"
+# define STATUS_CODE "1"
+#endif /* EXIT_STATUS == EXIT_SUCCESS */
+
+#define AUTHOR "netheround"
+
+/* every text is a single literal, written out with a single write(2). */
+
+static const char usage_text[] =
+    "Usage: " PROGRAM_NAME " [ignored command line arguments]\n"
+    "or: " PROGRAM_NAME " OPTION\n\n"
+    "Exit with a status code indicating " STATUS ".\n\n"
+    "Options:\n"
+    "  --help\tdisplay this help and exit\n"
+    "  --version\toutput version information and exit\n\n";
+
+static const char version_text[] =
+    PROGRAM_NAME " (EWE Coreutils) 0.0.1\n"
+    "Copyright (C) 2024\n"
+    "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
+    "This is free software: you are free to change and redistribute it.\n"
+    "\nWritten by " AUTHOR "\n";
+
+static const char verbose_text[] =
+    PROGRAM_NAME ": Exited with status code " STATUS_CODE " (" STATUS ")\n";
+
+int
+main (int argc, char **argv)
+{
+    /* options handling */
+    if (argc == 2) {
+        const char *arg = argv[1];
+
+        if (tiny_strcmp(arg, "--help") == 0)
+            tiny_write(STDOUT_FILENO, usage_text, sizeof(usage_text) - 1);
+        else if (tiny_strcmp(arg, "--version") == 0)
+            tiny_write(STDOUT_FILENO, version_text, sizeof(version_text) - 1);
+        else if (tiny_strcmp(arg, "--verbose") == 0 || tiny_strcmp(arg, "-v") == 0)
+            tiny_write(STDOUT_FILENO, verbose_text, sizeof(verbose_text) - 1);
+    }
+
+    /* exits with the fixed exit status. */
+    return EXIT_STATUS;
+}
@@ -0,0 +1,285 @@
+/* tt -- print the file name of the terminal connected to standard input (startup-minimal build)
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* Written by netheround <myemail@email.com> */
+/* gcc -Os -static -nostdlib -fno-stack-protector -fno-asynchronous-unwind-tables tiny/tt.c -o tt */
+
+/* Behaves exactly like ../tt.c, see ../include/tiny.c. */
+
+#include "../include/tiny.c"
+
+/* definintions */
+#define PROGRAM_NAME "tt"
+#define AUTHOR "netheround"
+
+/* the fds reported by --all */
+#define TT_ALL_FDS 3
+
+/* options */
+
+/* long options without a short equivalent. */
+enum
+{
+    FD_OPTION = 256,
+    ALL_OPTION,
+    HELP_OPTION,
+    VERSION_OPTION
+};
+
+static const struct tiny_option long_options[] = {
+    {"silent", false, 's'},
+    {"quiet", false, 's'},
+    {"fd", true, FD_OPTION},
+    {"all", false, ALL_OPTION},
+    {"help", false, HELP_OPTION},
+    {"version", false, VERSION_OPTION},
+
+    // terminating...
+    {0, 0, 0}
+};
+
+/* every text is a single literal, written out with a single write(2). */
+
+static const char try_text[] =
+    "Try '" PROGRAM_NAME " --help' for more information.\n";
+
+static const char usage_text[] =
+    "Usage " PROGRAM_NAME " [OPTION]...\n"
+    "Print the file name of the terminal connected to standard input.\n\n"
+    "Options\n"
+    "  -s, --silent, --quiet\tprint nothing, only return an exit status\n"
+    "      --fd=N\t\tlook at file descriptor N instead of standard input\n"
+    "      --all\t\treport file descriptors 0, 1 and 2, one 'N: NAME' line each\n"
+    "      --help\t\tdisplay this help and exit\n"
+    "      --version\toutput version information and exit\n\n";
+
+static const char version_text[] =
+    PROGRAM_NAME " (EWE Coreutils) 0.0.2\n"
+    "Copyright (C) 2024\n"
+    "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
+    "This is free software: you are free to change and redistribute it.\n"
+    "\nWritten by " AUTHOR "\n";
+
+/* where scan_terminal looks for a terminal, in this order, like ttyname_r */
+static const char *const terminal_dirs[] = {"/dev/pts", "/dev"};
+
+/* the name in DIR of the file with the device and inode of FD_ST, in BUF.
+   Only the entries with the right inode number are stat'ed. Returns its
+   length, 0 if there's none. */
+static long
+scan_dir (const char *dir, const struct tiny_stat *fd_st, char *buf, size_t size)
+{
+    int dir_fd = tiny_opendir(dir);
+    if (dir_fd == -1)
+        return 0;
+
+    /* 8-byte aligned, like the records getdents64 fills it with */
+    unsigned long dents[TINY_BUFSIZ / sizeof(unsigned long)];
+    size_t dir_len = strlen(dir);
+    long found = 0;
+    long n;
+
+    while (found == 0 && (n = tiny_getdents(dir_fd, dents, sizeof(dents))) > 0) {
+        for (long pos = 0; pos < n && found == 0;) {
+            struct tiny_dirent *d = (struct tiny_dirent *)((char *)dents + pos);
+            pos += d->reclen;
+
+            size_t name_len = strlen(d->name);
+            if (d->ino != fd_st->ino || dir_len + 1 + name_len >= size)
+                continue;
+
+            memcpy(buf, dir, dir_len);
+            buf[dir_len] = '/';
+            memcpy(buf + dir_len + 1, d->name, name_len + 1);
+
+            struct tiny_stat name_st;
+            if (tiny_stat(buf, &name_st) && name_st.dev == fd_st->dev && name_st.ino == fd_st->ino)
+                found = (long)(dir_len + 1 + name_len);
+        }
+    }
+
+    tiny_close(dir_fd);
+    return found;
+}
+
+/* like ttyname: the target of /proc/self/fd/FD, as long as it still is the
+   same file as FD. Without /proc (a chroot, some containers), the entries of
+   /dev/pts and /dev are searched instead, like ../tt.c does through
+   ttyname_r. Returns its length, 0 if there's no such name. */
+static long
+terminal_name (int fd, char *buf, size_t size)
+{
+    if (!tiny_isatty(fd))
+        return 0;
+
+    struct tiny_stat fd_st, name_st;
+    if (!tiny_fstat(fd, &fd_st))
+        return 0;
+
+    char link[32] = "/proc/self/fd/";
+    char *p = link + strlen(link);
+    p += tiny_utoa((unsigned long)fd, p);
+    *p = '\0';
+
+    long len = tiny_readlink(link, buf, size - 1);
+    if (len > 0) {
+        buf[len] = '\0';
+        if (tiny_stat(buf, &name_st) && fd_st.dev == name_st.dev && fd_st.ino == name_st.ino)
+            return len;
+    }
+
+    for (size_t i = 0; i < sizeof(terminal_dirs) / sizeof(*terminal_dirs); i++) {
+        len = scan_dir(terminal_dirs[i], &fd_st, buf, size);
+        if (len != 0)
+            return len;
+    }
+    return 0;
+}
+
+static bool
+parse_fd (const char *arg, int *fd)
+{
+    unsigned long n = 0;
+    if (*arg == '\0')
+        return false;
+
+    for (; *arg != '\0'; arg++) {
+        if (*arg < '0' || *arg > '9')
+            return false;
+        n = n * 10 + (unsigned long)(*arg - '0');
+        if (n > 0x7fffffff)
+            return false;
+    }
+
+    *fd = (int)n;
+    return true;
+}
+
+int
+main (int argc, char **argv)
+{
+    /* flag set by '--help, --version'. */
+    int verbose_flag = 0;
+
+    /* silent_mode, read more: https://en.wikipedia.org/wiki/Tty_(Unix) */
+    bool is_silent = false;
+
+    /* --fd N, or every fd up to TT_ALL_FDS with --all */
+    int fd = STDIN_FILENO;
+    bool is_all = false;
+
+    struct tiny_getopt opts = {0};
+    int c;
+    while ((c = tiny_getopt(&opts, argc, argv, "s", long_options)) != -1) {
+        switch (c)
+        {
+            case HELP_OPTION:
+                verbose_flag = 1;
+                break;
+
+            case VERSION_OPTION:
+                verbose_flag = 2;
+                break;
+
+            case 's':
+                is_silent = true;
+                break;
+
+            case FD_OPTION:
+                if (!parse_fd(opts.arg, &fd)) {
+                    tiny_print(STDOUT_FILENO, PROGRAM_NAME ": invalid file descriptor '", opts.arg, "'\n",
+                        try_text, NULL);
+                    return EXIT_FAILURE;
+                }
+                is_all = false;
+                break;
+
+            case ALL_OPTION:
+                is_all = true;
+                break;
+
+            default:
+                /* tiny_getopt aleardy printed an error message. */
+                tiny_write(STDOUT_FILENO, try_text, sizeof(try_text) - 1);
+                return EXIT_FAILURE;
+        }
+    }
+
+    switch (verbose_flag)
+    {
+        case 1:
+            tiny_write(STDOUT_FILENO, usage_text, sizeof(usage_text) - 1);
+            return EXIT_SUCCESS;
+        case 2:
+            tiny_write(STDOUT_FILENO, version_text, sizeof(version_text) - 1);
+            return EXIT_SUCCESS;
+    }
+
+    if (opts.operand != 0) {
+        tiny_print(STDOUT_FILENO, PROGRAM_NAME ": extra operand '", argv[opts.operand], "'\n",
+            try_text, NULL);
+        return EXIT_FAILURE;
+    }
+
+    int first = is_all ? 0 : fd;
+    int last = is_all ? TT_ALL_FDS - 1 : fd;
+
+    if (is_silent) {
+        for (int i = first; i <= last; i++)
+            if (!tiny_isatty(i))
+                return EXIT_FAILURE;
+        return EXIT_SUCCESS;
+    }
+
+    int status = EXIT_SUCCESS;
+
+    /* "N: " and the name and its newline, written at once */
+    char line[PATH_MAX + 16];
+    char num[16];
+
+    for (int i = first; i <= last; i++) {
+        num[tiny_utoa((unsigned long)i, num)] = '\0';
+
+        size_t prefix = 0;
+        if (is_all) {
+            prefix = strlen(num);
+            memcpy(line, num, prefix);
+            line[prefix++] = ':';
+            line[prefix++] = ' ';
+        }
+
+        long len = terminal_name(i, line + prefix, PATH_MAX);
+        if (len == 0) {
+            status = EXIT_FAILURE;
+            if (is_all) {
+                line[prefix] = '\0';
+                tiny_print(STDOUT_FILENO, line, "not a tty\n", NULL);
+            } else if (i == STDIN_FILENO) {
+                /* incase the tty hasnt been found. */
+                tiny_print(STDERR_FILENO, PROGRAM_NAME ": standard input is not connected to a terminal (not a tty)\n", NULL);
+            } else {
+                tiny_print(STDERR_FILENO, PROGRAM_NAME ": file descriptor ", num,
+                    " is not connected to a terminal (not a tty)\n", NULL);
+            }
+            continue;
+        }
+
+        line[prefix + (size_t)len] = '\n';
+        if (!tiny_write(STDOUT_FILENO, line, prefix + (size_t)len + 1))
+            status = EXIT_FAILURE;
+    }
+
+    return status;
+}
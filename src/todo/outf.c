@@ -14,23 +14,88 @@
    You should have received a copy of the GNU General Public License
    along with this program. If not, see <https://www.gnu.org/licenses/>. */
 /* Written by netheround <myemail@email.com> */
+/* gcc outf.c -o outf */
 
-/*
-    TODO: options
-    * Every single formatter for the `man 1 printf` using my custom printf implementation using `man 2 write`
-    * help page
-*/
+/* A printf(1) that doesn't go through stdio: everything is formatted
+   straight into one output arena, which is written with a single write(2)
+   (or writev(2), next to a long argument) when it fills up and at exit. So
+   millions of conversions cost a handful of system calls. */
 
 #include <stdio.h>
-#include <unistd.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+
+#include "../include/numfmt.c"
 
 /* definitions */
 
 #define PROGRAM_NAME "outf"
 #define AUTHOR "netheround"
 
+/* size of the output arena */
+#define OUTBUF_SIZE (64 * 1024)
+
+/* strings at least this long are handed to writev(2) as they are, rather
+   than copied into the arena */
+#define OUTBUF_DIRECT (OUTBUF_SIZE / 4)
+
+/* what --args-from reads at once, it only grows for a larger group */
+#define ARGS_BUFSIZE (128 * 1024)
+
+/* an output arena, data[0..used) is waiting to be written to fd. */
+struct outbuf
+{
+    char *data;
+    size_t size;
+    size_t used;
+    int fd;
+
+    /* errno of the first failed write, 0 if there was none */
+    int error;
+};
+
+/* a % directive, as found in the format */
+struct directive
+{
+    /* the flags, each one once, in the order they first appear */
+    char flags[8];
+
+    /* 0 without one, the '*' ones are taken from the arguments */
+    int width;
+    bool has_width_arg;
+
+    /* -1 without one */
+    int precision;
+    bool has_precision_arg;
+
+    /* 0 if the directive isn't valid */
+    char conversion;
+
+    /* the numeric conversions, as handed to vsnprintf when numfmt can't */
+    char spec[16];
+    unsigned numfmt_flags;
+};
+
+static struct outbuf out;
+
+/* the value to return */
+static int exit_status;
+
+/* set by \c, nothing gets printed after it */
+static bool is_stopped;
+
+/* POSIXLY_CORRECT is set in the environment */
+static bool is_posixly_correct;
+
 // ...
 
 void
@@ -41,7 +106,40 @@ usage (int status)
         exit(status);
     }
 
-    puts("help");
+    printf("Usage: %s FORMAT [ARGUMENT]...\n"
+    "  or:  %s --args-from FILE [--null] FORMAT\n"
+    "  or:  %s OPTION\n"
+    "Print ARGUMENT(s) according to FORMAT.\n\n", PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME);
+
+    puts("Options:\n"
+    "  --args-from FILE\tread the arguments from FILE, one per line,\n"
+    "\t\t\tstandard input when FILE is -\n"
+    "  --null\t\twith --args-from, arguments end with a NUL, not a newline\n"
+    "  --help\tdisplay this help and exit\n"
+    "  --version\toutput version information and exit\n");
+
+    puts("FORMAT controls the output as in C printf. Interpreted sequences are:\n\n"
+    "  \\\"\t\tdouble quote\n"
+    "  \\\\\t\tbackslash\n"
+    "  \\a\t\talert (BEL)\n"
+    "  \\b\t\tbackspace\n"
+    "  \\c\t\tproduce no further output\n"
+    "  \\e\t\tescape\n"
+    "  \\f\t\tform feed\n"
+    "  \\n\t\tnew line\n"
+    "  \\r\t\tcarriage return\n"
+    "  \\t\t\thorizontal tab\n"
+    "  \\v\t\tvertical tab\n"
+    "  \\NNN\t\tbyte with octal value NNN (1 to 3 digits)\n"
+    "  \\xHH\t\tbyte with hexadecimal value HH (1 to 2 digits)\n"
+    "  \\uHHHH\tUnicode character with hex value HHHH (4 digits), in UTF-8\n"
+    "  \\UHHHHHHHH\tUnicode character with hex value HHHHHHHH (8 digits), in UTF-8\n"
+    "  %%\t\ta single %\n"
+    "  %b\t\tARGUMENT as a string with '\\' escapes interpreted,\n"
+    "\t\texcept that octal escapes are of the form \\0 or \\0NNN\n\n"
+    "and all C format specifications ending with one of diouxXfeEgGaAcs, with\n"
+    "ARGUMENTs converted to proper type first. Variable widths are handled.\n"
+    "FORMAT is reused as many times as needed to consume every ARGUMENT.");
     exit(status);
 }
 
@@ -56,20 +154,1008 @@ version_info()
     exit(EXIT_SUCCESS);
 }
 
-int
-output_formatted (const char *format, ...)
+/* prints a message, and exits if IS_FATAL. */
+static void
+report (bool is_fatal, const char *format, ...)
 {
-    // ...
     va_list args;
     va_start(args, format);
+    fprintf(stderr, "%s: ", PROGRAM_NAME);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+
+    exit_status = EXIT_FAILURE;
+    if (is_fatal)
+        exit(EXIT_FAILURE);
+}
+
+/* output */
+
+static void
+outbuf_init (struct outbuf *ob, int fd, size_t size)
+{
+    ob->data = (char *)malloc(size);
+    if (ob->data == NULL)
+        report(true, "memory exhausted");
+
+    ob->size = size;
+    ob->used = 0;
+    ob->fd = fd;
+    ob->error = 0;
+}
+
+/* writes all of IOV, once a write failed everything is dropped. */
+static void
+outbuf_writev (struct outbuf *ob, struct iovec *iov, int iovcnt)
+{
+    while (iovcnt > 0 && ob->error == 0) {
+        ssize_t n = writev(ob->fd, iov, iovcnt);
+        if (n == -1) {
+            if (errno != EINTR)
+                ob->error = errno;
+            continue;
+        }
+
+        /* a short write, skip what went out */
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+}
+
+static void
+outbuf_flush (struct outbuf *ob)
+{
+    if (ob->used == 0)
+        return;
+
+    struct iovec iov = {ob->data, ob->used};
+    outbuf_writev(ob, &iov, 1);
+    ob->used = 0;
+}
+
+/* Returns room for N bytes at the end of the arena, flushing it first if
+   they don't fit, and growing it for a conversion larger than it is.
+   Whatever gets written there is committed by adding to ob->used. */
+static char *
+outbuf_reserve (struct outbuf *ob, size_t n)
+{
+    if (ob->size - ob->used >= n)
+        return ob->data + ob->used;
+
+    outbuf_flush(ob);
+    if (n > ob->size) {
+        char *data = (char *)realloc(ob->data, n);
+        if (data == NULL)
+            report(true, "memory exhausted");
+        ob->data = data;
+        ob->size = n;
+    }
+    return ob->data;
+}
+
+static void
+outbuf_put (struct outbuf *ob, const char *s, size_t len)
+{
+    if (ob->size - ob->used >= len) {
+        memcpy(ob->data + ob->used, s, len);
+        ob->used += len;
+        return;
+    }
+
+    /* no point copying a long string, it goes out with what's buffered */
+    if (len >= OUTBUF_DIRECT) {
+        struct iovec iov[2] = {{ob->data, ob->used}, {(void *)s, len}};
+        outbuf_writev(ob, iov, 2);
+        ob->used = 0;
+        return;
+    }
+
+    outbuf_flush(ob);
+    memcpy(ob->data, s, len);
+    ob->used = len;
+}
+
+/* puts C, N times. */
+static void
+outbuf_fill (struct outbuf *ob, char c, size_t n)
+{
+    while (n > 0) {
+        if (ob->used == ob->size)
+            outbuf_flush(ob);
+
+        size_t chunk = ob->size - ob->used;
+        if (chunk > n)
+            chunk = n;
+        memset(ob->data + ob->used, c, chunk);
+        ob->used += chunk;
+        n -= chunk;
+    }
+}
+
+/* formats with vsnprintf straight into the arena. */
+static void
+outbuf_printf (struct outbuf *ob, const char *format, ...)
+{
+    va_list args, again;
+    va_start(args, format);
+    va_copy(again, args);
 
+    size_t room = ob->size - ob->used;
+    int n = vsnprintf(ob->data + ob->used, room, format, args);
+    if (n < 0)
+        report(true, "%s: %s", format, strerror(errno));
+
+    /* it didn't fit (vsnprintf wants room for the '\0' too) */
+    if ((size_t)n >= room) {
+        char *p = outbuf_reserve(ob, (size_t)n + 1);
+        vsnprintf(p, (size_t)n + 1, format, again);
+    }
+    ob->used += (size_t)n;
+
+    va_end(again);
     va_end(args);
 }
 
+/* flushes the output at exit, like close_stdout. */
+static void
+close_output (void)
+{
+    outbuf_flush(&out);
+    if (out.error != 0) {
+        fprintf(stderr, "%s: write error: %s\n", PROGRAM_NAME, strerror(out.error));
+        _exit(EXIT_FAILURE);
+    }
+}
+
+/* arguments */
+
+static void
+verify_numeric (const char *s, const char *end)
+{
+    if (errno != 0)
+        report(false, "'%s': %s", s, strerror(errno));
+    else if (*end != '\0')
+        report(false, s == end ? "'%s': expected a numeric value"
+            : "'%s': value not completely converted", s);
+}
+
+/* 'c or "c stands for the value of the character c. */
+static bool
+char_constant (const char *s, unsigned char *c)
+{
+    if ((*s != '"' && *s != '\'') || s[1] == '\0')
+        return false;
+
+    *c = (unsigned char)s[1];
+    if (s[2] != '\0' && !is_posixly_correct) {
+        fprintf(stderr, "%s: warning: %s: character(s) following character constant have been ignored\n",
+            PROGRAM_NAME, s + 2);
+    }
+    return true;
+}
+
+static intmax_t
+to_intmax (const char *s)
+{
+    unsigned char c;
+    if (char_constant(s, &c))
+        return c;
+
+    char *end;
+    errno = 0;
+    intmax_t value = strtoimax(s, &end, 0);
+    verify_numeric(s, end);
+    return value;
+}
+
+static uintmax_t
+to_uintmax (const char *s)
+{
+    unsigned char c;
+    if (char_constant(s, &c))
+        return c;
+
+    char *end;
+    errno = 0;
+    uintmax_t value = strtoumax(s, &end, 0);
+    verify_numeric(s, end);
+    return value;
+}
+
+static long double
+to_long_double (const char *s)
+{
+    unsigned char c;
+    if (char_constant(s, &c))
+        return c;
+
+    char *end;
+    errno = 0;
+    long double value = strtold(s, &end);
+    verify_numeric(s, end);
+    return value;
+}
+
+/* escapes */
+
+/* the most an escape sequence decodes to: \U00110000, printed back */
+#define ESCAPE_MAX 10
+
+/* an escape sequence, decoded */
+struct escape
+{
+    char bytes[ESCAPE_MAX];
+    size_t len;
+
+    /* \c */
+    bool is_stop;
+
+    /* why it's invalid, empty if it isn't */
+    char error[64];
+};
+
+static int
+hex_value (char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static bool
+is_octal (char c)
+{
+    return c >= '0' && c <= '7';
+}
+
+/* writes the code point U in UTF-8 to BUF, returns the length. KIND ('u' or 'U')
+   is the escape that introduced it. */
+static size_t
+encode_unicode (uint32_t u, char kind, char *buf)
+{
+    if (u < 0x80) {
+        buf[0] = (char)u;
+        return 1;
+    }
+    if (u < 0x800) {
+        buf[0] = (char)(0xC0 | u >> 6);
+        buf[1] = (char)(0x80 | (u & 0x3F));
+        return 2;
+    }
+    if (u < 0x10000) {
+        buf[0] = (char)(0xE0 | u >> 12);
+        buf[1] = (char)(0x80 | (u >> 6 & 0x3F));
+        buf[2] = (char)(0x80 | (u & 0x3F));
+        return 3;
+    }
+    if (u < 0x110000) {
+        buf[0] = (char)(0xF0 | u >> 18);
+        buf[1] = (char)(0x80 | (u >> 12 & 0x3F));
+        buf[2] = (char)(0x80 | (u >> 6 & 0x3F));
+        buf[3] = (char)(0x80 | (u & 0x3F));
+        return 4;
+    }
+
+    /* not a character, printed back the way GNU printf does */
+    char tmp[ESCAPE_MAX + 1];
+    int len = snprintf(tmp, sizeof(tmp), kind == 'u' ? "\\u%04" PRIX32 : "\\U%08" PRIX32, u);
+    memcpy(buf, tmp, (size_t)len);
+    return (size_t)len;
+}
+
+/* Decodes the escape sequence at ESC (the backslash) into E, returns the
+   number of characters in it besides the backslash. With IS_OCTAL_0 (%b)
+   octal escapes are \0NNN, otherwise \NNN. */
+static int
+decode_escape (const char *esc, bool is_octal_0, struct escape *e)
+{
+    const char *p = esc + 1;
+    int value = 0;
+    int len;
+
+    e->len = 0;
+    e->is_stop = false;
+    e->error[0] = '\0';
+
+    if (*p == 'x') {
+        for (len = 0, p++; len < 2 && hex_value(*p) != -1; len++, p++)
+            value = value * 16 + hex_value(*p);
+        if (len == 0)
+            snprintf(e->error, sizeof(e->error), "missing hexadecimal number in escape");
+        else
+            e->bytes[e->len++] = (char)value;
+    } else if (is_octal(*p)) {
+        for (len = 0, p += is_octal_0 && *p == '0'; len < 3 && is_octal(*p); len++, p++)
+            value = value * 8 + (*p - '0');
+        e->bytes[e->len++] = (char)value;
+    } else if (*p == 'u' || *p == 'U') {
+        char kind = *p++;
+        uint32_t u = 0;
+        for (len = kind == 'u' ? 4 : 8; len > 0; len--, p++) {
+            if (hex_value(*p) == -1) {
+                snprintf(e->error, sizeof(e->error), "missing hexadecimal number in escape");
+                return (int)(p - esc - 1);
+            }
+            u = u * 16 + (uint32_t)hex_value(*p);
+        }
+
+        if (u >= 0xD800 && u <= 0xDFFF)
+            snprintf(e->error, sizeof(e->error), "invalid universal character name \\%c%0*" PRIx32,
+                kind, kind == 'u' ? 4 : 8, u);
+        else
+            e->len = encode_unicode(u, kind, e->bytes);
+    } else if (*p != '\0' && strchr("\"\\abcefnrtv", *p) != NULL) {
+        switch (*p++)
+        {
+            case 'a': e->bytes[e->len++] = '\a'; break;
+            case 'b': e->bytes[e->len++] = '\b'; break;
+            case 'c': e->is_stop = true; break;
+            case 'e': e->bytes[e->len++] = '\x1B'; break;
+            case 'f': e->bytes[e->len++] = '\f'; break;
+            case 'n': e->bytes[e->len++] = '\n'; break;
+            case 'r': e->bytes[e->len++] = '\r'; break;
+            case 't': e->bytes[e->len++] = '\t'; break;
+            case 'v': e->bytes[e->len++] = '\v'; break;
+            default: e->bytes[e->len++] = p[-1]; break;
+        }
+    } else {
+        /* not an escape after all */
+        e->bytes[e->len++] = '\\';
+        if (*p != '\0')
+            e->bytes[e->len++] = *p++;
+    }
+    return (int)(p - esc - 1);
+}
+
+/* %b, stops at a \c. */
+static void
+put_escaped_string (const char *s)
+{
+    while (!is_stopped) {
+        size_t run = strcspn(s, "\\");
+        outbuf_put(&out, s, run);
+        s += run;
+        if (*s == '\0')
+            break;
+
+        struct escape e;
+        s += 1 + decode_escape(s, true, &e);
+        if (e.error[0] != '\0')
+            report(true, "%s", e.error);
+        outbuf_put(&out, e.bytes, e.len);
+        is_stopped = e.is_stop;
+    }
+}
+
+/* the program */
+
+/* The format is compiled once into a list of ops, which is then run as many
+   times as it takes to use every argument: literal text (with its escapes
+   already decoded) is copied as it is, only the conversions do any work. */
+
+enum op_kind
+{
+    /* text[0..len) of the pool */
+    OP_LITERAL,
+    /* %b */
+    OP_ESCAPED_STRING,
+    /* any other conversion */
+    OP_CONVERSION,
+    /* \c, the end of all output */
+    OP_STOP,
+    /* a broken escape or directive, the message is in the pool */
+    OP_ERROR
+};
+
+struct op
+{
+    enum op_kind kind;
+
+    /* OP_LITERAL and OP_ERROR */
+    size_t offset;
+    size_t len;
+
+    /* OP_CONVERSION */
+    struct directive d;
+};
+
+struct program
+{
+    struct op *ops;
+    size_t nops;
+
+    /* the decoded literals and messages */
+    char *pool;
+    size_t pool_len;
+    size_t pool_size;
+
+    /* the arguments a run of it uses, with the '*' ones */
+    int nargs;
+};
+
+static void
+program_free (struct program *prog)
+{
+    free(prog->ops);
+    free(prog->pool);
+    memset(prog, 0, sizeof(*prog));
+}
+
+/* appends S (LEN bytes) to the pool, returns where it starts. */
+static size_t
+pool_add (struct program *prog, const char *s, size_t len)
+{
+    if (prog->pool_size - prog->pool_len < len) {
+        size_t size = prog->pool_size * 2 + len;
+        char *pool = (char *)realloc(prog->pool, size);
+        if (pool == NULL)
+            report(true, "memory exhausted");
+        prog->pool = pool;
+        prog->pool_size = size;
+    }
+
+    size_t offset = prog->pool_len;
+    memcpy(prog->pool + offset, s, len);
+    prog->pool_len += len;
+    return offset;
+}
+
+static struct op *
+program_add (struct program *prog, enum op_kind kind)
+{
+    struct op *op = &prog->ops[prog->nops++];
+    memset(op, 0, sizeof(*op));
+    op->kind = kind;
+    return op;
+}
+
+/* adds literal text, merged with the literal before it if there's one. */
+static void
+program_add_literal (struct program *prog, const char *s, size_t len)
+{
+    if (len == 0)
+        return;
+
+    size_t offset = pool_add(prog, s, len);
+    struct op *last = prog->nops > 0 ? &prog->ops[prog->nops - 1] : NULL;
+    if (last != NULL && last->kind == OP_LITERAL && last->offset + last->len == offset) {
+        last->len += len;
+        return;
+    }
+
+    struct op *op = program_add(prog, OP_LITERAL);
+    op->offset = offset;
+    op->len = len;
+}
+
+static void
+program_add_error (struct program *prog, const char *message, size_t len)
+{
+    struct op *op = program_add(prog, OP_ERROR);
+    op->len = len;
+    op->offset = pool_add(prog, message, len);
+}
+
+/* adds flag C to D, unless it already has it. */
+static void
+add_flag (struct directive *d, char c)
+{
+    size_t len = strlen(d->flags);
+    if (memchr(d->flags, c, len) == NULL && len + 1 < sizeof(d->flags)) {
+        d->flags[len] = c;
+        d->flags[len + 1] = '\0';
+    }
+}
+
+/* reads the digits at *P into VALUE, false if it doesn't fit in an int. */
+static bool
+parse_count (const char **p, int *value)
+{
+    int n = 0;
+    bool is_ok = true;
+    for (; **p >= '0' && **p <= '9'; (*p)++) {
+        if (n > (INT_MAX - (**p - '0')) / 10)
+            is_ok = false;
+        else
+            n = n * 10 + (**p - '0');
+    }
+    *value = n;
+    return is_ok;
+}
+
+/* Parses the directive at START (the '%') into D. Returns where it ends,
+   after the conversion character (d->conversion is 0 if it isn't valid). */
+static const char *
+parse_directive (const char *start, struct directive *d)
+{
+    /* ok['x'] is true while %x is allowed with what has been seen so far */
+    bool ok[UCHAR_MAX + 1] = {0};
+    ok['a'] = ok['A'] = ok['c'] = ok['d'] = ok['e'] = ok['E'] = ok['f'] = ok['F']
+        = ok['g'] = ok['G'] = ok['i'] = ok['o'] = ok['s'] = ok['u'] = ok['x'] = ok['X'] = true;
+
+    const char *f = start + 1;
+    bool is_valid = true;
+
+    memset(d, 0, sizeof(*d));
+    d->precision = -1;
+
+    for (;; f++) {
+        switch (*f)
+        {
+            case 'I':
+            case '\'':
+                ok['a'] = ok['A'] = ok['c'] = ok['e'] = ok['E'] = ok['o'] = ok['s']
+                    = ok['x'] = ok['X'] = false;
+                break;
+            case '-':
+            case '+':
+            case ' ':
+                break;
+            case '#':
+                ok['c'] = ok['d'] = ok['i'] = ok['s'] = ok['u'] = false;
+                break;
+            case '0':
+                ok['c'] = ok['s'] = false;
+                break;
+            default:
+                goto no_more_flags;
+        }
+        add_flag(d, *f);
+    }
+no_more_flags:
+
+    if (*f == '*') {
+        f++;
+        d->has_width_arg = true;
+    } else {
+        is_valid = parse_count(&f, &d->width);
+    }
+
+    if (*f == '.') {
+        f++;
+        ok['c'] = false;
+        if (*f == '*') {
+            f++;
+            d->has_precision_arg = true;
+        } else {
+            is_valid = parse_count(&f, &d->precision) && is_valid;
+        }
+    }
+
+    /* every argument is as wide as it can be anyway */
+    while (*f == 'l' || *f == 'L' || *f == 'h' || *f == 'j' || *f == 't' || *f == 'z')
+        f++;
+
+    if (!ok[(unsigned char)*f] || !is_valid)
+        return *f == '\0' ? f : f + 1;
+
+    d->conversion = *f;
+
+    /* what the numeric conversions hand to vsnprintf: "%" FLAGS "*.*" LENGTH CONVERSION */
+    char *q = d->spec;
+    *q++ = '%';
+    for (const char *flag = d->flags; *flag != '\0'; flag++)
+        *q++ = *flag;
+    *q++ = '*';
+    *q++ = '.';
+    *q++ = '*';
+    if (strchr("diouxX", *f) != NULL)
+        *q++ = 'j';
+    else if (strchr("aAeEfFgG", *f) != NULL)
+        *q++ = 'L';
+    *q++ = *f;
+    *q = '\0';
+
+    for (const char *flag = d->flags; *flag != '\0'; flag++) {
+        switch (*flag)
+        {
+            case '-': d->numfmt_flags |= NUMFMT_LEFT; break;
+            case '+': d->numfmt_flags |= NUMFMT_PLUS; break;
+            case ' ': d->numfmt_flags |= NUMFMT_SPACE; break;
+            case '#': d->numfmt_flags |= NUMFMT_ALT; break;
+            case '0': d->numfmt_flags |= NUMFMT_ZERO; break;
+            default: d->numfmt_flags |= NUMFMT_LOCALE; break;
+        }
+    }
+
+    return f + 1;
+}
+
+/* compiles FORMAT into PROG. */
+static void
+compile_format (struct program *prog, const char *format)
+{
+    size_t len = strlen(format);
+    memset(prog, 0, sizeof(*prog));
+
+    /* every op takes up at least one character of the format */
+    prog->ops = (struct op *)malloc((len + 1) * sizeof(*prog->ops));
+    if (prog->ops == NULL)
+        report(true, "memory exhausted");
+
+    const char *f = format;
+    while (true) {
+        size_t run = strcspn(f, "%\\");
+        program_add_literal(prog, f, run);
+        f += run;
+
+        if (*f == '\0')
+            break;
+
+        if (*f == '\\') {
+            struct escape e;
+            f += 1 + decode_escape(f, false, &e);
+            if (e.error[0] != '\0') {
+                program_add_error(prog, e.error, strlen(e.error));
+                break;
+            }
+            program_add_literal(prog, e.bytes, e.len);
+            if (e.is_stop) {
+                program_add(prog, OP_STOP);
+                break;
+            }
+            continue;
+        }
+
+        /* *f == '%' */
+        if (f[1] == '%') {
+            program_add_literal(prog, "%", 1);
+            f += 2;
+            continue;
+        }
+
+        if (f[1] == 'b') {
+            program_add(prog, OP_ESCAPED_STRING);
+            prog->nargs++;
+            f += 2;
+            continue;
+        }
+
+        struct directive d;
+        const char *end = parse_directive(f, &d);
+        if (d.conversion == '\0') {
+            char message[256];
+            int n = snprintf(message, sizeof(message), "%.*s: invalid conversion specification",
+                (int)(end - f), f);
+            program_add_error(prog, message, (size_t)n < sizeof(message) ? (size_t)n : sizeof(message) - 1);
+            break;
+        }
+
+        program_add(prog, OP_CONVERSION)->d = d;
+        prog->nargs += 1 + d.has_width_arg + d.has_precision_arg;
+        f = end;
+    }
+}
+
+/* conversions */
+
+/* the next argument, "" once there are none left. */
+static const char *
+next_arg (int *argc, char ***argv)
+{
+    if (*argc <= 0)
+        return "";
+    (*argc)--;
+    return *(*argv)++;
+}
+
+/* puts S (LEN bytes) padded to WIDTH, negative for left adjusted. */
+static void
+put_padded (const struct directive *d, int width, const char *s, size_t len)
+{
+    bool is_left = width < 0 || strchr(d->flags, '-') != NULL;
+    size_t w = width < 0 ? -(size_t)width : (size_t)width;
+    size_t pad = w > len ? w - len : 0;
+
+    if (!is_left)
+        outbuf_fill(&out, ' ', pad);
+    outbuf_put(&out, s, len);
+    if (is_left)
+        outbuf_fill(&out, ' ', pad);
+}
+
+/* runs the conversion D, taking its '*' values and argument from ARGV. */
+static void
+put_conversion (const struct directive *d, int *argc, char ***argv)
+{
+    int width = d->width;
+    int precision = d->precision;
+
+    if (d->has_width_arg) {
+        width = 0;
+        if (*argc > 0) {
+            intmax_t value = to_intmax(**argv);
+            if (value < INT_MIN || value > INT_MAX)
+                report(true, "invalid field width: '%s'", **argv);
+            width = (int)value;
+            next_arg(argc, argv);
+        }
+    }
+
+    if (d->has_precision_arg) {
+        precision = 0;
+        if (*argc > 0) {
+            intmax_t value = to_intmax(**argv);
+            /* a negative one is as good as none */
+            if (value < 0)
+                precision = -1;
+            else if (value > INT_MAX)
+                report(true, "invalid precision: '%s'", **argv);
+            else
+                precision = (int)value;
+            next_arg(argc, argv);
+        }
+    }
+
+    const char *arg = next_arg(argc, argv);
+    struct numfmt nf = {d->numfmt_flags, width, precision, d->conversion};
+    size_t n;
+
+    switch (d->conversion)
+    {
+        case 'd':
+        case 'i': {
+            intmax_t value = to_intmax(arg);
+            n = numfmt_integer(&nf, (uintmax_t)value, outbuf_reserve(&out, NUMFMT_SIZE));
+            if (n != 0)
+                out.used += n;
+            else
+                outbuf_printf(&out, d->spec, width, precision, value);
+            break;
+        }
+
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X': {
+            uintmax_t value = to_uintmax(arg);
+            n = numfmt_integer(&nf, value, outbuf_reserve(&out, NUMFMT_SIZE));
+            if (n != 0)
+                out.used += n;
+            else
+                outbuf_printf(&out, d->spec, width, precision, value);
+            break;
+        }
+
+        case 'a':
+        case 'A':
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G': {
+            long double value = to_long_double(arg);
+            n = numfmt_float(&nf, value, outbuf_reserve(&out, NUMFMT_SIZE));
+            if (n != 0)
+                out.used += n;
+            else
+                outbuf_printf(&out, d->spec, width, precision, value);
+            break;
+        }
+
+        case 'c':
+            put_padded(d, width, arg, 1);
+            break;
+
+        case 's': {
+            size_t len = precision < 0 ? strlen(arg) : strnlen(arg, (size_t)precision);
+            put_padded(d, width, arg, len);
+            break;
+        }
+    }
+}
+
+/* Runs PROG once, using the ARGC arguments in ARGV for its conversions.
+   Returns the number of arguments used. */
+int
+output_formatted (const struct program *prog, int argc, char **argv)
+{
+    int save_argc = argc;
+
+    for (const struct op *op = prog->ops; op < prog->ops + prog->nops; op++) {
+        switch (op->kind)
+        {
+            case OP_LITERAL:
+                outbuf_put(&out, prog->pool + op->offset, op->len);
+                break;
+
+            case OP_ESCAPED_STRING:
+                if (argc > 0)
+                    put_escaped_string(next_arg(&argc, &argv));
+                if (is_stopped)
+                    return save_argc - argc;
+                break;
+
+            case OP_CONVERSION:
+                put_conversion(&op->d, &argc, &argv);
+                break;
+
+            case OP_STOP:
+                is_stopped = true;
+                return save_argc - argc;
+
+            case OP_ERROR:
+                report(true, "%.*s", (int)op->len, prog->pool + op->offset);
+                break;
+        }
+    }
+
+    return save_argc - argc;
+}
+
+/* --args-from */
+
+/* arguments read from a file, a group at a time */
+struct arg_reader
+{
+    int fd;
+    const char *name;
+    char delimiter;
+
+    /* buf[start..end) is read but not handed out yet */
+    char *buf;
+    size_t size;
+    size_t start;
+    size_t end;
+    bool is_eof;
+
+    /* where the arguments of the group being read start */
+    size_t *offsets;
+};
+
+static void
+arg_reader_init (struct arg_reader *r, const char *name, char delimiter, int group)
+{
+    memset(r, 0, sizeof(*r));
+    r->name = name;
+    r->delimiter = delimiter;
+
+    if (strcmp(name, "-") == 0) {
+        r->fd = STDIN_FILENO;
+    } else {
+        r->fd = open(name, O_RDONLY);
+        if (r->fd == -1)
+            report(true, "%s: %s", name, strerror(errno));
+    }
+
+    r->size = ARGS_BUFSIZE;
+    r->buf = (char *)malloc(r->size);
+    r->offsets = (size_t *)malloc((size_t)(group > 0 ? group : 1) * sizeof(*r->offsets));
+    if (r->buf == NULL || r->offsets == NULL)
+        report(true, "memory exhausted");
+}
+
+static void
+arg_reader_free (struct arg_reader *r)
+{
+    if (r->fd != STDIN_FILENO)
+        close(r->fd);
+    free(r->buf);
+    free(r->offsets);
+}
+
+/* Reads more input after r->end, making room first (the group being read
+   moves to the start of the buffer, or the buffer grows). False at EOF. */
+static bool
+arg_reader_fill (struct arg_reader *r)
+{
+    if (r->start > 0) {
+        memmove(r->buf, r->buf + r->start, r->end - r->start);
+        r->end -= r->start;
+        r->start = 0;
+    }
+
+    /* one byte is kept for the '\0' after the last argument */
+    if (r->size - r->end < 2) {
+        char *buf = (char *)realloc(r->buf, r->size * 2);
+        if (buf == NULL)
+            report(true, "memory exhausted");
+        r->buf = buf;
+        r->size *= 2;
+    }
+
+    while (true) {
+        ssize_t n = read(r->fd, r->buf + r->end, r->size - r->end - 1);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n == -1)
+            report(true, "%s: %s", r->name, strerror(errno));
+
+        r->end += (size_t)n;
+        r->is_eof = n == 0;
+        return !r->is_eof;
+    }
+}
+
+/* Reads up to N arguments into ARGV, they stay valid until the next call.
+   Returns how many were read, fewer than N only at the end of the input. */
+static int
+arg_reader_next (struct arg_reader *r, char **argv, int n)
+{
+    int count = 0;
+    size_t pos = r->start;
+
+    while (count < n) {
+        char *delimiter = (char *)memchr(r->buf + pos, r->delimiter, r->end - pos);
+        if (delimiter != NULL) {
+            *delimiter = '\0';
+            r->offsets[count++] = pos - r->start;
+            pos = (size_t)(delimiter - r->buf) + 1;
+            continue;
+        }
+
+        if (r->is_eof) {
+            /* the last argument, without a delimiter after it */
+            if (pos < r->end) {
+                r->buf[r->end] = '\0';
+                r->offsets[count++] = pos - r->start;
+                pos = r->end;
+            }
+            break;
+        }
+
+        /* the group so far moves along with the rest of the buffer */
+        pos -= r->start;
+        arg_reader_fill(r);
+        pos += r->start;
+    }
+
+    for (int i = 0; i < count; i++)
+        argv[i] = r->buf + r->start + r->offsets[i];
+    r->start = pos;
+    return count;
+}
+
+/* runs PROG over the arguments in NAME. */
+static void
+output_from (const struct program *prog, const char *name, char delimiter)
+{
+    struct arg_reader r;
+    arg_reader_init(&r, name, delimiter, prog->nargs);
+
+    char **argv = (char **)malloc((size_t)(prog->nargs > 0 ? prog->nargs : 1) * sizeof(*argv));
+    if (argv == NULL)
+        report(true, "memory exhausted");
+
+    /* like the argv loop: at least once, then until the arguments run out */
+    int n = arg_reader_next(&r, argv, prog->nargs);
+    while (true) {
+        output_formatted(prog, n, argv);
+        if (is_stopped || n < prog->nargs || prog->nargs == 0)
+            break;
+        n = arg_reader_next(&r, argv, prog->nargs);
+        if (n == 0)
+            break;
+    }
+
+    if (prog->nargs == 0 && !is_stopped && arg_reader_next(&r, argv, 1) > 0)
+        fprintf(stderr, "%s: warning: ignoring excess arguments, starting with '%s'\n",
+            PROGRAM_NAME, argv[0]);
+
+    free(argv);
+    arg_reader_free(&r);
+}
+
 int
 main (int argc, char **argv)
 {
-    /* options handling */
+    const char *args_from = NULL;
+    char delimiter = '\n';
+
+    /* options handling, no abbreviations: the format could start with "--" */
     if (argc == 2) {
         if (strcmp(argv[1], "--help") == 0) {
             usage(EXIT_SUCCESS);
@@ -78,5 +1164,73 @@ main (int argc, char **argv)
         }
     }
 
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    /* only before the format */
+    while (argc > 1) {
+        if (strcmp(argv[1], "--args-from") == 0) {
+            if (argc == 2) {
+                fprintf(stderr, "%s: option '--args-from' requires an argument\n", PROGRAM_NAME);
+                usage(EXIT_FAILURE);
+            }
+            args_from = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else if (strncmp(argv[1], "--args-from=", 12) == 0) {
+            args_from = argv[1] + 12;
+            argc--;
+            argv++;
+        } else if (strcmp(argv[1], "--null") == 0) {
+            delimiter = '\0';
+            argc--;
+            argv++;
+        } else {
+            break;
+        }
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--") == 0) {
+        argc--;
+        argv++;
+    }
+
+    if (argc <= 1) {
+        fprintf(stderr, "%s: missing operand\n", PROGRAM_NAME);
+        usage(EXIT_FAILURE);
+    }
+
+    if (args_from != NULL && argc > 2) {
+        fprintf(stderr, "%s: extra operand '%s'\n", PROGRAM_NAME, argv[2]);
+        usage(EXIT_FAILURE);
+    }
+
+    exit_status = EXIT_SUCCESS;
+    is_posixly_correct = getenv("POSIXLY_CORRECT") != NULL;
+
+    outbuf_init(&out, STDOUT_FILENO, OUTBUF_SIZE);
+    atexit(close_output);
+
+    struct program prog;
+    compile_format(&prog, argv[1]);
+
+    if (args_from != NULL) {
+        output_from(&prog, args_from, delimiter);
+        program_free(&prog);
+        return exit_status;
+    }
+
+    argc -= 2;
+    argv += 2;
+
+    int used;
+    do {
+        used = output_formatted(&prog, argc, argv);
+        argc -= used;
+        argv += used;
+    } while (used > 0 && argc > 0 && !is_stopped);
+
+    if (argc > 0 && !is_stopped)
+        fprintf(stderr, "%s: warning: ignoring excess arguments, starting with '%s'\n",
+            PROGRAM_NAME, argv[0]);
+
+    program_free(&prog);
+    return exit_status;
+}
@@ -1 +1,594 @@
-// `man 1 rmdir`
\ No newline at end of file
+/* rd/rmdir -- remove empty directories
+   Copyright (C) 2024 The EWE Project.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <https://www.gnu.org/licenses/>. */
+/* Written by netheround <myemail@email.com> */
+/* gcc rd.c -o rd */
+
+// `man 1 rmdir`
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <getopt.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <dirent.h>
+
+#include "../include/config.h"
+#include "../include/stripslash.c"
+
+/* definitions */
+
+#ifdef _WIN32
+# include <direct.h>
+
+# define rd_rmdir(path) (_rmdir(path))
+
+/* only passed to is_non_empty, which can't look on Windows */
+# ifndef AT_FDCWD
+#  define AT_FDCWD (-100)
+# endif /* AT_FDCWD */
+#else
+# define rd_rmdir(path) (rmdir(path))
+# define rd_rmdirat(fd, name) (unlinkat((fd), (name), AT_REMOVEDIR))
+
+/* only looked up through, never read: O_PATH needs no read permission */
+# ifdef O_PATH
+#  define rd_opendirat(fd, name) (openat((fd), (name), O_PATH | O_DIRECTORY | O_CLOEXEC))
+# else
+#  define rd_opendirat(fd, name) (openat((fd), (name), O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+# endif /* O_PATH */
+#endif /* _WIN32 */
+
+/* rmdir.c overrides this, acts like "rd" by default. */
+#ifndef PROGRAM_NAME
+# define PROGRAM_NAME "rd"
+#endif /* PROGRAM_NAME */
+
+#define AUTHOR "netheround"
+
+/* how many ancestor fds `-p` keeps open at most. */
+#define RD_MAX_OPEN_DIRS 64
+
+// ...
+
+/* options */
+
+/* long options without a short equivalent. */
+enum
+{
+    IGNORE_FAIL_ON_NON_EMPTY_OPTION = CHAR_MAX + 1,
+    HELP_OPTION,
+    VERSION_OPTION
+};
+
+static struct option const long_options[] = {
+    /* these options set a flag. */
+    {"parents", no_argument, 0, 'p'},
+    {"verbose", no_argument, 0, 'v'},
+    {"ignore-fail-on-non-empty", no_argument, 0, IGNORE_FAIL_ON_NON_EMPTY_OPTION},
+
+    /* these options don't set a flag. */
+    {"help", no_argument, 0, HELP_OPTION},
+    {"version", no_argument, 0, VERSION_OPTION},
+
+    // terminating...
+    {0, 0, 0, 0}
+};
+
+/* Everything a run of rd works with. Nothing lives in file-static
+   variables, so rd can run more than once in the same process. */
+struct rd_state
+{
+    /* parents option, see: `man 1 rmdir` */
+    bool is_parents;
+
+    /* verbose option, see: `man 1 rmdir` */
+    bool is_verbose;
+
+    /* a directory that can't be removed because it isn't empty is no error. */
+    bool is_ignore_non_empty;
+
+    /* '-p': the ancestors of the current DIRECTORY, shallowest first, as
+       where each one ends in the path and where its own name starts (after
+       its parent and the slashes following it). */
+    size_t *ends;
+    size_t *starts;
+    size_t nancestors;
+    size_t ancestors_size;
+
+#ifndef _WIN32
+    /* the fds of the ancestors fds_lo and up, open at the moment. */
+    int fds[RD_MAX_OPEN_DIRS];
+    size_t fds_lo;
+    size_t fds_used;
+#endif /* _WIN32 */
+};
+
+// ...
+
+/* prints the verbose message for DIRNAME, about to be removed. */
+static void
+report_removing (struct rd_state *rd, const char *dirname)
+{
+    if (rd->is_verbose)
+        printf("%s: removing directory, '%s'\n", PROGRAM_NAME, dirname);
+}
+
+/* IS_ANCESTOR: DIRNAME is one of the parents removed by '-p'. Like GNU
+   rmdir, an ancestor that isn't a directory (a symlink) isn't called one. */
+static void
+report_failure (const char *dirname, bool is_ancestor, int err)
+{
+    /* keep the messages in order with the verbose ones */
+    fflush(stdout);
+    fprintf(stderr, "%s: failed to remove %s'%s': %s\n", PROGRAM_NAME,
+        is_ancestor && err != ENOTDIR ? "directory " : "", dirname, strerror(err));
+}
+
+/* Whether the directory NAME, relative to the directory FD, has anything
+   in it besides "." and "..". Not knowing counts as no. */
+static bool
+is_non_empty (int fd, const char *name)
+{
+#ifdef _WIN32
+    (void)fd;
+    (void)name;
+    return false;
+#else
+    int dir_fd = openat(fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1)
+        return false;
+
+    DIR *dir = fdopendir(dir_fd);
+    if (dir == NULL) {
+        close(dir_fd);
+        return false;
+    }
+
+    bool found = false;
+    struct dirent *entry;
+    while (!found && (entry = readdir(dir)) != NULL)
+        found = strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0;
+    closedir(dir);
+    return found;
+#endif /* _WIN32 */
+}
+
+/* Whether failing to remove NAME (relative to FD) with ERR is to be ignored:
+   with '--ignore-fail-on-non-empty', when the directory wasn't empty. Some
+   systems check the permissions before the contents, then it is looked at. */
+static bool
+is_ignorable (struct rd_state *rd, int fd, const char *name, int err)
+{
+    if (!rd->is_ignore_non_empty)
+        return false;
+    if (err == ENOTEMPTY || err == EEXIST)
+        return true;
+    if (err == EACCES || err == EPERM || err == EROFS || err == EBUSY)
+        return is_non_empty(fd, name);
+    return false;
+}
+
+/* Reports failing to remove DIRNAME, the operand itself, with ERR. A
+   symbolic link to a directory with a trailing slash is refused by Linux
+   with ENOTDIR, which is spelled out. */
+static void
+report_operand_failure (const char *dirname, int err)
+{
+#ifndef _WIN32
+    size_t len = strlen(dirname);
+    if (err == ENOTDIR && len > 1 && dirname[len - 1] == '/') {
+        char *link = strdup(dirname);
+        struct stat st;
+        if (link != NULL) {
+            strip_trailing_slashes(link);
+            bool is_link = lstat(link, &st) == 0 && S_ISLNK(st.st_mode);
+            free(link);
+
+            if (is_link) {
+                fflush(stdout);
+                fprintf(stderr, "%s: failed to remove '%s': Symbolic link not followed\n",
+                    PROGRAM_NAME, dirname);
+                return;
+            }
+        }
+    }
+#endif /* _WIN32 */
+
+    report_failure(dirname, false, err);
+}
+
+/* Removes DIRNAME, the operand itself. Returns 0, or -1 on an error. */
+static int
+remove_dir (struct rd_state *rd, const char *dirname)
+{
+    report_removing(rd, dirname);
+    if (rd_rmdir(dirname) == 0)
+        return 0;
+
+    int err = errno;
+    if (is_ignorable(rd, AT_FDCWD, dirname, err))
+        return 0;
+
+    report_operand_failure(dirname, err);
+    return -1;
+}
+
+/* Finds the ancestors of PATH (without trailing slashes) the way truncating
+   it at its last slashes over and over does: "a/b/c" has "a/b" and "a",
+   "/a/b" has "/a" and "/". Returns -1 when out of memory. */
+static int
+find_ancestors (struct rd_state *rd, const char *path)
+{
+    size_t len = strlen(path);
+    rd->nancestors = 0;
+
+    /* deepest first, reversed below */
+    while (true) {
+        size_t end = len;
+        while (end > 0 && path[end - 1] != '/')
+            end--;
+        if (end == 0)
+            break;
+
+        /* skip the slashes, but keep the root */
+        end--;
+        while (end > 0 && path[end - 1] == '/')
+            end--;
+        if (end == 0)
+            end = 1;
+        if (end == len)
+            break;
+
+        if (rd->nancestors == rd->ancestors_size) {
+            size_t size = rd->ancestors_size == 0 ? 16 : rd->ancestors_size * 2;
+            size_t *ends = (size_t *)realloc(rd->ends, size * sizeof(*ends));
+            if (ends == NULL)
+                return -1;
+            rd->ends = ends;
+
+            size_t *starts = (size_t *)realloc(rd->starts, size * sizeof(*starts));
+            if (starts == NULL)
+                return -1;
+            rd->starts = starts;
+            rd->ancestors_size = size;
+        }
+        rd->ends[rd->nancestors++] = end;
+        len = end;
+    }
+
+    for (size_t i = 0, j = rd->nancestors; i + 1 < j; i++, j--) {
+        size_t end = rd->ends[i];
+        rd->ends[i] = rd->ends[j - 1];
+        rd->ends[j - 1] = end;
+    }
+
+    for (size_t i = 0; i < rd->nancestors; i++) {
+        size_t start = i == 0 ? 0 : rd->ends[i - 1];
+        while (i > 0 && path[start] == '/')
+            start++;
+        rd->starts[i] = start;
+    }
+    return 0;
+}
+
+/* Removes the ancestors of PATH from ancestor TOP up, by their path every
+   time, like rmdir always did. Returns 0, or -1 on an error. */
+static int
+remove_parents_by_path (struct rd_state *rd, char *path, size_t top)
+{
+    for (size_t i = top + 1; i-- > 0;) {
+        char saved = path[rd->ends[i]];
+        path[rd->ends[i]] = '\0';
+
+        report_removing(rd, path);
+        int status = rd_rmdir(path);
+        int err = errno;
+        bool is_ignored = status == -1 && is_ignorable(rd, AT_FDCWD, path, err);
+
+        if (status == -1 && !is_ignored)
+            report_failure(path, true, err);
+        path[rd->ends[i]] = saved;
+
+        if (status == -1)
+            return is_ignored ? 0 : -1;
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+static void
+close_ancestors (struct rd_state *rd)
+{
+    for (size_t i = 0; i < rd->fds_used; i++)
+        close(rd->fds[i]);
+    rd->fds_used = 0;
+}
+
+/* the fd of ancestor I, which must be open. */
+static int
+ancestor_fd (struct rd_state *rd, size_t i)
+{
+    return rd->fds[i - rd->fds_lo];
+}
+
+/* Opens every ancestor of PATH down to HI, each relative to the one above
+   it, and keeps the deepest RD_MAX_OPEN_DIRS of them. Returns -1 if one
+   can't be opened. */
+static int
+open_ancestors (struct rd_state *rd, char *path, size_t hi)
+{
+    close_ancestors(rd);
+    rd->fds_lo = hi + 1 > RD_MAX_OPEN_DIRS ? hi + 1 - RD_MAX_OPEN_DIRS : 0;
+
+    int parent = AT_FDCWD;
+    for (size_t i = 0; i <= hi; i++) {
+        char saved = path[rd->ends[i]];
+        path[rd->ends[i]] = '\0';
+        int fd = rd_opendirat(parent, path + rd->starts[i]);
+        path[rd->ends[i]] = saved;
+
+        /* above the window, only needed to open the next one */
+        if (i > 0 && i - 1 < rd->fds_lo)
+            close(parent);
+        if (fd == -1) {
+            close_ancestors(rd);
+            return -1;
+        }
+
+        if (i >= rd->fds_lo)
+            rd->fds[rd->fds_used++] = fd;
+        parent = fd;
+    }
+    return 0;
+}
+
+/* '-p': removes PATH (without trailing slashes) and then each of its
+   ancestors, every one with a single lookup relative to the fd of its
+   parent, held open on the way down, instead of resolving the whole path
+   again. PATH is modified temporarily, but restored before returning.
+   DIRNAME is PATH as it was given. */
+static int
+remove_parents (struct rd_state *rd, const char *dirname, char *path)
+{
+    size_t n = rd->nancestors;
+    size_t leaf = rd->ends[n - 1];
+    while (path[leaf] == '/')
+        leaf++;
+
+    if (open_ancestors(rd, path, n - 1) == -1) {
+        /* with the same messages as without fds */
+        if (remove_dir(rd, dirname) == -1)
+            return -1;
+        return remove_parents_by_path(rd, path, n - 1);
+    }
+
+    report_removing(rd, dirname);
+    if (rd_rmdirat(ancestor_fd(rd, n - 1), path + leaf) == -1) {
+        int err = errno;
+        int status = is_ignorable(rd, ancestor_fd(rd, n - 1), path + leaf, err) ? 0 : -1;
+        if (status == -1)
+            report_operand_failure(dirname, err);
+        close_ancestors(rd);
+
+        /* the leaf stays, so do its parents */
+        return status;
+    }
+
+    for (size_t i = n; i-- > 0;) {
+        /* past the window, open the next one */
+        if (i > 0 && i - 1 < rd->fds_lo && open_ancestors(rd, path, i - 1) == -1)
+            return remove_parents_by_path(rd, path, i);
+
+        int parent = i == 0 ? AT_FDCWD : ancestor_fd(rd, i - 1);
+        char saved = path[rd->ends[i]];
+        path[rd->ends[i]] = '\0';
+
+        report_removing(rd, path);
+        int status = rd_rmdirat(parent, path + rd->starts[i]);
+        int err = errno;
+        bool is_ignored = status == -1 && is_ignorable(rd, parent, path + rd->starts[i], err);
+
+        if (status == -1 && !is_ignored)
+            report_failure(path, true, err);
+        path[rd->ends[i]] = saved;
+
+        if (status == -1) {
+            close_ancestors(rd);
+            return is_ignored ? 0 : -1;
+        }
+    }
+
+    close_ancestors(rd);
+    return 0;
+}
+#endif /* _WIN32 */
+
+int
+remove_dirs (struct rd_state *rd, const char *dirname)
+{
+    if (!rd->is_parents)
+        return remove_dir(rd, dirname);
+
+    char *dir_cpy = strdup(dirname);
+    if (dir_cpy == NULL) {
+        fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+        return -1;
+    }
+
+    /* Normalize directory path */
+    strip_trailing_slashes(dir_cpy);
+
+    int status;
+    if (find_ancestors(rd, dir_cpy) == -1) {
+        fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+        status = -1;
+    } else if (rd->nancestors == 0) {
+        status = remove_dir(rd, dirname);
+    } else {
+#ifdef _WIN32
+        status = remove_dir(rd, dirname);
+        if (status == 0)
+            status = remove_parents_by_path(rd, dir_cpy, rd->nancestors - 1);
+#else
+        status = remove_parents(rd, dirname, dir_cpy);
+#endif /* _WIN32 */
+    }
+
+    free(dir_cpy);
+    return status;
+}
+
+int
+usage (int status)
+{
+    if (status != EXIT_SUCCESS) {
+        printf("Try '%s --help' for more information.\n", PROGRAM_NAME);
+        return status;
+    }
+
+    printf("Usage: %s [OPTION]... DIRECTORY...\n"
+    "Remove the DIRECTORY(ies), if they are empty.\n\n", PROGRAM_NAME);
+
+    puts("Options:\n"
+    "  -p, --parents\t\tremove DIRECTORY and its ancestors, as long as they become empty\n"
+    "  -v, --verbose\t\tprint a message for each directory removed\n"
+    "      --ignore-fail-on-non-empty\n"
+    "\t\t\tno error for a directory that isn't empty\n\n"
+
+    "      --help\t\tdisplay this help and exit\n"
+    "      --version\toutput version information and exit\n");
+
+    printf("Examples:\n"
+    "  %s test      -> removes directory 'test' if it is empty.\n"
+    "  %s -p a/b/c  -> removes 'a/b/c', then 'a/b', then 'a'.\n"
+    "  %s -p --ignore-fail-on-non-empty a/b   -> removes 'a/b', and 'a' too if nothing else is in it.\n",
+    PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME);
+    return status;
+}
+
+int
+version_info()
+{
+    printf("%s (EWE Coreutils) 0.0.1\n"
+    "Copyright (C) 2024\n"
+    "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
+    "This is free software: you are free to change and redistribute it.\n"
+    "\nWritten by %s\n", PROGRAM_NAME, AUTHOR);
+    return EXIT_SUCCESS;
+}
+
+/* releases everything RD holds. */
+static void
+rd_cleanup (struct rd_state *rd)
+{
+    fflush(stdout);
+#ifndef _WIN32
+    close_ancestors(rd);
+#endif /* _WIN32 */
+    free(rd->ends);
+    free(rd->starts);
+    free(rd);
+}
+
+/* Runs rd with ARGV and returns its exit status, without ever exiting. */
+int
+rd_run (int argc, char **argv)
+{
+    struct rd_state *rd = (struct rd_state *)calloc(1, sizeof(*rd));
+    if (rd == NULL) {
+        fprintf(stderr, "%s: memory allocation failed\n", PROGRAM_NAME);
+        return EXIT_FAILURE;
+    }
+
+    /* flag set by '--help, --version'. */
+    int verbose_flag = 0;
+    int status = EXIT_SUCCESS;
+    int c;
+
+    reset_getopt();
+    while ((c = getopt_long(argc, argv, "pv", long_options, NULL)) != -1) {
+        switch (c)
+        {
+            case 'p':
+                rd->is_parents = true;
+                break;
+
+            case 'v':
+                rd->is_verbose = true;
+                break;
+
+            case IGNORE_FAIL_ON_NON_EMPTY_OPTION:
+                rd->is_ignore_non_empty = true;
+                break;
+
+            case HELP_OPTION:
+                verbose_flag = 1;
+                break;
+
+            case VERSION_OPTION:
+                verbose_flag = 2;
+                break;
+
+            case '?':
+                /* getopt_long aleardy printed an error message. */
+
+                status = usage(EXIT_FAILURE);
+                goto done;
+
+            default:
+                status = usage(2);
+                goto done;
+        }
+    }
+
+    switch (verbose_flag)
+    {
+        case 1:
+            status = usage(EXIT_SUCCESS);
+            goto done;
+        case 2:
+            status = version_info();
+            goto done;
+    }
+
+    if (optind == argc) {
+        fprintf(stderr, "%s: missing operand\n", PROGRAM_NAME);
+        status = usage(EXIT_FAILURE);
+        goto done;
+    }
+
+    /* every DIRECTORY is attempted, even after a failure */
+    while (optind < argc) {
+        if (remove_dirs(rd, argv[optind++]) == -1)
+            status = EXIT_FAILURE;
+    }
+
+done:
+    rd_cleanup(rd);
+    return status;
+}
+
+int
+main (int argc, char **argv)
+{
+    return rd_run(argc, argv);
+}
@@ -33,10 +33,7 @@
 
 #define AUTHOR "netheround"
 
-/* verbose_mode for making a call once exiting. */
-bool verbose_mode = false;
-
-void
+int
 usage (int status)
 {
     printf("Usage: %s [ignored command line arguments]\n"
@@ -49,10 +46,10 @@ usage (int status)
     "  --help\tdisplay this help and exit\n"
     "  --version\toutput version information and exit\n");
 
-    exit(status);
+    return status;
 }
 
-void
+int
 version_info()
 {
     printf("%s (EWE Coreutils) 0.0.1\n"
@@ -60,18 +57,22 @@ version_info()
     "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
     "This is free software: you are free to change and redistribute it.\n"
     "\nWritten by %s\n", PROGRAM_NAME, AUTHOR);
-    exit(EXIT_STATUS);
+    return EXIT_STATUS;
 }
 
+/* Runs true (or false) with ARGV and returns its exit status, without ever exiting. */
 int
-main (int argc, char **argv)
+true_run (int argc, char **argv)
 {
+    /* verbose_mode for making a call once exiting. */
+    bool verbose_mode = false;
+
     /* options handling */
     if (argc == 2) {
         if (strcmp(argv[1], "--help") == 0) {
-            usage(EXIT_STATUS);
+            return usage(EXIT_STATUS);
         } else if (strcmp(argv[1], "--version") == 0) {
-            version_info();
+            return version_info();
         } else if (strcmp(argv[1], "--verbose") == 0
             || strcmp(argv[1], "-v") == 0) {
             
@@ -85,4 +86,10 @@ main (int argc, char **argv)
 
     /* exits with the fixed exit status. */
     return EXIT_STATUS;
-}
\ No newline at end of file
+}
+
+int
+main (int argc, char **argv)
+{
+    return true_run(argc, argv);
+}
@@ -20,29 +20,48 @@
 #include <stdbool.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <limits.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "include/config.h"
 
 /* definintions */
 #define PROGRAM_NAME "tt"
 #define AUTHOR "netheround"
 
+/* PATH_MAX definitions for limits.h */
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif /* PATH_MAX */
+
+/* the fds reported by --all */
+#define TT_ALL_FDS 3
+
 // ...
 
 /* options */
 
-/* flag set by '--help, --version'. */
-static int verbose_flag;
-
-/* silent_mode, read more: https://en.wikipedia.org/wiki/Tty_(Unix) */
-static bool is_silent = false;
+/* long options without a short equivalent. */
+enum
+{
+    FD_OPTION = CHAR_MAX + 1,
+    ALL_OPTION,
+    HELP_OPTION,
+    VERSION_OPTION
+};
 
-static struct option long_options[] = {
+static struct option const long_options[] = {
     /* these options set a flag. */
     {"silent", no_argument, 0, 's'},
     {"quiet", no_argument, 0, 's'},
+    {"fd", required_argument, 0, FD_OPTION},
+    {"all", no_argument, 0, ALL_OPTION},
 
     /* these options don't set a flag. */
-    {"help", no_argument, &verbose_flag, 1},
-    {"version", no_argument, &verbose_flag, 2},
+    {"help", no_argument, 0, HELP_OPTION},
+    {"version", no_argument, 0, VERSION_OPTION},
 
     // terminating...
     {0, 0, 0, 0}
@@ -50,12 +69,12 @@ static struct option long_options[] = {
 
 // ...
 
-void
+int
 usage (int status)
 {
     if (status != EXIT_SUCCESS) {
         printf("Try '%s --help' for more information.\n", PROGRAM_NAME);
-        exit(status);
+        return status;
     }
 
     printf("Usage %s [OPTION]...\n"
@@ -63,12 +82,14 @@ usage (int status)
 
     puts("Options\n"
     "  -s, --silent, --quiet\tprint nothing, only return an exit status\n"
+    "      --fd=N\t\tlook at file descriptor N instead of standard input\n"
+    "      --all\t\treport file descriptors 0, 1 and 2, one 'N: NAME' line each\n"
     "      --help\t\tdisplay this help and exit\n"
     "      --version\toutput version information and exit\n");
-    exit(status);
+    return status;
 }
 
-void
+int
 version_info()
 {
     printf("%s (EWE Coreutils) 0.0.2\n"
@@ -76,13 +97,67 @@ version_info()
     "License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n"
     "This is free software: you are free to change and redistribute it.\n"
     "\nWritten by %s\n", PROGRAM_NAME, AUTHOR);
-    exit(EXIT_SUCCESS);
+    return EXIT_SUCCESS;
+}
+
+/* The name of the terminal FD is connected to, in BUF, or NULL if it isn't
+   one. /proc/self/fd/FD links to it, which is only trusted once it has the
+   same device and inode as FD; ttyname_r, which may stat every entry of
+   /dev/pts and /dev, is only the fallback. */
+static const char *
+terminal_name (int fd, char *buf, size_t size)
+{
+    if (!isatty(fd))
+        return NULL;
+
+#ifdef __linux__
+    char link[64];
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+
+    ssize_t len = readlink(link, buf, size - 1);
+    if (len > 0) {
+        buf[len] = '\0';
+
+        struct stat fd_st, name_st;
+        if (fstat(fd, &fd_st) == 0 && stat(buf, &name_st) == 0
+            && S_ISCHR(name_st.st_mode)
+            && fd_st.st_dev == name_st.st_dev && fd_st.st_ino == name_st.st_ino)
+            return buf;
+    }
+#endif /* __linux__ */
+
+    return ttyname_r(fd, buf, size) == 0 ? buf : NULL;
+}
+
+static bool
+parse_fd (const char *arg, int *fd)
+{
+    char *endptr;
+    errno = 0;
+    long n = strtol(arg, &endptr, 10);
+    if (endptr == arg || *endptr != '\0' || errno == ERANGE || n < 0 || n > INT_MAX)
+        return false;
+
+    *fd = (int)n;
+    return true;
 }
 
+/* Runs tt with ARGV and returns its exit status, without ever exiting. */
 int
-main (int argc, char **argv)
+tt_run (int argc, char **argv)
 {
+    /* flag set by '--help, --version'. */
+    int verbose_flag = 0;
+
+    /* silent_mode, read more: https://en.wikipedia.org/wiki/Tty_(Unix) */
+    bool is_silent = false;
+
+    /* --fd N, or every fd up to TT_ALL_FDS with --all */
+    int fd = STDIN_FILENO;
+    bool is_all = false;
+
     int c;
+    reset_getopt();
     while (true) {
         int option_ind = 0;
         c = getopt_long(argc, argv, "s", long_options, &option_ind);
@@ -92,54 +167,88 @@ main (int argc, char **argv)
         
         switch (c)
         {
-            case 0:
-                if (long_options[option_ind].flag != 0)
-                    break;
-                printf("option %s", long_options[option_ind].name);
-                if (optarg)
-                    printf(" with arg %s\n", optarg);
+            case HELP_OPTION:
+                verbose_flag = 1;
+                break;
+
+            case VERSION_OPTION:
+                verbose_flag = 2;
                 break;
             
             case 's':
                 is_silent = true;
                 break;
+
+            case FD_OPTION:
+                if (!parse_fd(optarg, &fd)) {
+                    printf("%s: invalid file descriptor '%s'\n", PROGRAM_NAME, optarg);
+                    return usage(EXIT_FAILURE);
+                }
+                is_all = false;
+                break;
+
+            case ALL_OPTION:
+                is_all = true;
+                break;
             
             case '?':
                 /* getopt_long aleardy printed an error message. */
 
-                usage(EXIT_FAILURE);
-                break;
+                return usage(EXIT_FAILURE);
             
             default:
-                usage(2);
+                return usage(2);
         }
     };
 
     switch (verbose_flag)
     {
         case 1:
-            usage(EXIT_SUCCESS);
+            return usage(EXIT_SUCCESS);
         case 2:
-            version_info();
+            return version_info();
     }
 
     if (optind < argc) {
         printf("%s: extra operand '%s'\n", PROGRAM_NAME, argv[optind]);
-        usage(EXIT_FAILURE);
+        return usage(EXIT_FAILURE);
     }
 
-    if (is_silent)
-        return isatty(STDIN_FILENO) ? EXIT_SUCCESS : EXIT_FAILURE;
-    
-    int status = EXIT_SUCCESS;
-    const char *tt = ttyname(STDIN_FILENO);
+    int first = is_all ? 0 : fd;
+    int last = is_all ? TT_ALL_FDS - 1 : fd;
 
-    /* incase the tty hasnt been found. */
-    if (!tt) {
-        fprintf(stderr, "%s: standard input is not connected to a terminal (not a tty)\n", PROGRAM_NAME);
-        status = EXIT_FAILURE;
+    if (is_silent) {
+        for (int i = first; i <= last; i++)
+            if (!isatty(i))
+                return EXIT_FAILURE;
+        return EXIT_SUCCESS;
+    }
+
+    int status = EXIT_SUCCESS;
+    char tt[PATH_MAX];
+
+    for (int i = first; i <= last; i++) {
+        const char *name = terminal_name(i, tt, sizeof(tt));
+        if (name == NULL)
+            status = EXIT_FAILURE;
+
+        if (is_all) {
+            printf("%d: %s\n", i, name ? name : "not a tty");
+        } else if (name != NULL) {
+            puts(name);
+        } else if (i == STDIN_FILENO) {
+            /* incase the tty hasnt been found. */
+            fprintf(stderr, "%s: standard input is not connected to a terminal (not a tty)\n", PROGRAM_NAME);
+        } else {
+            fprintf(stderr, "%s: file descriptor %d is not connected to a terminal (not a tty)\n", PROGRAM_NAME, i);
+        }
     }
 
-    puts(tt);
     return status;
-}
\ No newline at end of file
+}
+
+int
+main (int argc, char **argv)
+{
+    return tt_run(argc, argv);
+}